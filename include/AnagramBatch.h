@@ -0,0 +1,53 @@
+#ifndef ANAGRAM_BATCH_H
+#define ANAGRAM_BATCH_H
+
+#include <string_view>  //For std::string_view
+#include <cstdint>     //For uint32_t
+#include <cstddef>    //For size_t
+#include <string>    //For std::string
+#include <vector>   //For std::vector
+
+const size_t ANAGRAM_BATCH_BYTES = 64 << 10; //An expander hands its batch to the I/O thread once it holds this many bytes
+
+//Identifies a batch of signature solutions of a task. The search of a task is deterministic, and its batches are cut
+//at first level entry boundaries, so a rerun of the task numbers its batches the same way
+struct BatchTag
+{
+    size_t task = 0;             //Index of the task in the schedule
+    uint64_t seq = 0;            //Number of the batch in its task
+    size_t entry = 0;            //First level entry of its solutions
+    uint64_t entryBase = 0;      //Number of the first batch of that entry
+    bool lastOfEntry = false;    //True if no batch of the same entry follows
+};
+
+//Anagrams formatted by an expander, stored contiguously: every entry is its length (4 bytes) followed by its text
+//The I/O thread pops whole batches, so the queue lock is taken once per batch rather than once per anagram
+class AnagramBatch
+{
+public:
+    AnagramBatch() = default;
+
+    //Appends the words as one entry, separated by spaces, after the tag and a tab if there's a tag
+    void append(const std::vector<std::string_view> &words, std::string_view tag = {});
+
+    //Returns the entry starting at 'offset', and moves 'offset' to the next one
+    std::string_view next(size_t &offset) const;
+
+    //Getters
+    size_t size() const  {return count;}
+    size_t bytes() const {return buffer.size();}
+    bool empty() const   {return count == 0;}
+    std::string_view last() const;
+
+    void clear();
+
+    //Signature batches whose anagrams are all in this batch, or in earlier ones of the same expander
+    std::vector<BatchTag> tags;
+
+private:
+    std::string buffer;
+    size_t count = 0;
+    size_t lastOffset = 0; //Offset of the last entry, shown on the progress line
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef ANAGRAM_RING_H
+#define ANAGRAM_RING_H
+
+#include <cstdint>   //For uint32_t
+#include <cstddef>  //For size_t
+#include <memory>  //For std::unique_ptr
+#include <atomic> //For std::atomic
+#include <array> //For std::array
+
+#include "AnagramBatch.h"
+
+const size_t ANAGRAM_RING_CAPACITY = 256; //Batches in flight between the expanders and the I/O thread, a power of two
+const int ANAGRAM_RING_SPINS = 256;       //Checks the I/O thread makes before parking
+
+//Bounded lock-free multi-producer single-consumer ring of anagram batches (Vyukov's bounded queue).
+//Every slot carries a sequence number telling whether it is free or published for the current lap, so producers
+//only contend on the tail index, with a CAS, and never wait for each other. A producer only waits when the ring is
+//full, and the consumer parks on an atomic counter when it is empty
+class AnagramRing
+{
+public:
+    AnagramRing();
+    AnagramRing(const AnagramRing&) = delete;
+    ~AnagramRing();
+
+    //Producers: publishes a batch, waits only if the ring is full
+    void push(std::unique_ptr<AnagramBatch> batch);
+
+    //Consumer: returns the oldest batch, nullptr if the ring is empty
+    std::unique_ptr<AnagramBatch> pop();
+
+    //Consumer: spins briefly, then parks until a batch is published, 'done' is set or wake() is called
+    void waitForBatch(const std::atomic<bool> &done);
+
+    //Wakes the consumer up, to check 'done' or to refresh the progress line
+    void wake();
+
+private:
+    struct alignas(64) Slot
+    {
+        std::atomic<size_t> sequence;
+        AnagramBatch* batch = nullptr;
+    };
+    std::array<Slot, ANAGRAM_RING_CAPACITY> slots;
+
+    alignas(64) std::atomic<size_t> tail = 0;         //Next slot to publish, shared by the producers
+    alignas(64) size_t head = 0;                      //Next slot to consume, owned by the consumer
+    alignas(64) std::atomic<uint32_t> published = 0;  //Bumped on every push and wake, the consumer parks on it☢️
+    std::atomic<bool> consumerParked = false;
+    alignas(64) std::atomic<uint32_t> freed = 0;      //Bumped on every pop, full producers park on it☢️
+    std::atomic<int> producersParked = 0;
+
+    bool tryPush(AnagramBatch* batch);
+    bool empty() const;
+};
+
+#endif
@@ -5,73 +5,196 @@
 #include <string>          //For std::string
 #include <vector>          //For std::vector
 #include <memory>          //For std::unique_ptr
+#include <functional>      //For std::function
 #include <set>             //For std::set and std::multiset
+#include <cstdint>         //For uint64_t
 
 //Thread safety
-#include <condition_variable>  //For std::condition_variable
 #include <thread>              //For std::jthread
+#include <stop_token>          //For std::stop_source, std::stop_token
+#include <chrono>              //For std::chrono
 #include <atomic>              //For nuclear energy☢️
-#include <mutex>               //For std::mutex
-#include <queue>               //For std::queue
 
 #include "WordSignature.h"
 #include "Dictionarium.h"
+#include "SetPlanner.h"
+#include "PairSumTables.h"
+#include "TranspositionTable.h"
+#include "SolutionPipeline.h"
+#include "AnagramBatch.h"
+#include "AnagramRing.h"
+#include "Checkpoint.h"
+#include "WordScores.h"
+#include "TopAnagrams.h"
+#include "WorkStealingPool.h"
+
+//Search engines, they produce the same anagrams
+enum class SearchEngine
+{
+    Recursive,  //Recursive walk of the levels
+    Iterative,  //Explicit stack of per-depth cursors
+    Letter      //Rarest letter first, over every length at once, see LetterSearch
+};
+
+//Why the search was cut short, if it was
+enum class StopReason
+{
+    None,       //The search covered every set
+    Limit,      //The requested number of anagrams was found
+    Timeout,    //The time budget ran out
+    Interrupt   //SIGINT
+};
+
+//An included text, and what it leaves to the search
+struct Alternative
+{
+    std::string includedText;
+    WordSignature includedSignature;
+    int includedWordsNumber = 0;
+    int minCardinality = 0, maxCardinality = 0; //Words the search must find
+    size_t query = 0;                           //Query that searches its target
+    double includedScore = 0.0;                 //Score of the included text, part of every anagram of a ranked search
+};
+
+//A target left by one or more alternatives, searched once for all of them over the union of their cardinalities
+struct SearchQuery
+{
+    WordSignature target;
+    int minCardinality, maxCardinality;
+    std::vector<size_t> alternatives;           //Indices of its alternatives
+    double bestIncludedScore = 0.0;             //Best score of their included texts, bound of a ranked search
+};
+
+const auto WATCHDOG_PERIOD = std::chrono::milliseconds(10); //How often the timeout and SIGINT are checked
+const auto PROGRESS_PERIOD = std::chrono::milliseconds(1000); //How often the progress line is refreshed
 
 class ArmaMagna
 {
     friend class SearchThread;
+    friend class LetterSearch;
+    friend class SolutionPipeline;
 
 public:
     ArmaMagna();
     auto anagram() -> std::expected<unsigned long long, std::string>;
     auto setOptions(const std::string &text, const std::string &dictionary, const std::string& outputFileName, 
-                    const std::string &included, int mincard, int maxcard, int numThreads)
+                    const std::vector<std::string> &included, int mincard, int maxcard, int numThreads)
                     -> std::expected<void, std::string>;
 
     //Setters
     auto setTargetText(const std::string targetText) -> std::expected<void, std::string>;
     void setDictionaryName(const std::string dictionaryName);
-    auto setIncludedText(const std::string includedText) -> std::expected<void, std::string>;
+    auto setIncludedTexts(const std::vector<std::string> &includedTexts) -> std::expected<void, std::string>;
     auto setRestrictions(int minCardinality, int maxCardinality) -> std::expected<void, std::string>;
+    auto setLengthBounds(int minLength, int maxLength) -> std::expected<void, std::string>;
     void setThreadsNumber(unsigned int n);
+    void setSchedulePolicy(SchedulePolicy policy);
+    void setSearchEngine(SearchEngine engine);
+    void setExpandersNumber(unsigned int n);
+    auto setBudget(unsigned long long maxAnagrams, double timeoutSeconds) -> std::expected<void, std::string>;
+    auto setCheckpointing(double periodSeconds, bool resume) -> std::expected<void, std::string>;
+    auto setShard(int index, int number) -> std::expected<void, std::string>;
+    void setRanking(size_t topNumber, const std::string &scoresFileName);
+    void setExclusions(const std::string &excludeFileName, const std::vector<std::string> &anyOf);
+    auto setWordFilters(const std::vector<std::string> &patterns) -> std::expected<void, std::string>;
+    void setPinning(bool pinned);
+
+    //Asks the running search to stop, async-signal-safe
+    static void interrupt();
 
 private:
     //Constructor arguments
     std::string targetText;
-    std::string includedText;
+    std::vector<std::string> includedTexts;             //Alternative included texts, a single empty one if there's none
     std::string dictionaryName;
     std::string outputFileName;
     int minCardinality, maxCardinality;
+    int minLength = 1, maxLength = MAX_WORD_LENGTH; //Lengths of the dictionary words an anagram can use
+    std::string excludeFileName;                    //Words the anagrams never use, one per line
+    std::vector<std::string> anyOf;                 //An anagram must include at least one of them, empty for no constraint
+    std::vector<std::string> wordFilterPatterns;    //Every dictionary word must pass all of them
 
     //Processed variables
     Dictionarium dictionary; //Shared but read-only for threads
-    WordSignature targetSignature, includedTextSignature, actualTargetSignature; //actualTargetSignature = targetTextSignature - includedTextSignature
-    int includedWordsNumber;
-    int actualMinCardinality, actualMaxCardinality;
+    std::vector<std::unique_ptr<Dictionarium>> replicas;        //Copies of the dictionary on every NUMA node, empty if there's a single one
+    std::vector<std::unique_ptr<PairSumTables>> pairSumTables; //One per copy of the dictionary, built lazily by the threads
+    std::atomic<size_t> pairTablesMemory = 0;                   //Bytes of all of them, against PAIR_TABLES_MEMORY_CAP☢️
+    TranspositionTable transpositionTable;        //Shared memo of the subproblems solved by the threads
+    WordSignature targetSignature;
+    int includedWordsNumber = 0;                        //Words of the longest included text
+    std::vector<Alternative> alternatives;              //Included texts of the current search
+    std::vector<SearchQuery> queries;                   //Distinct targets they leave, searched in one shared pool
+    bool taggedOutput = false;                          //With several included texts, every anagram starts with its own
     unsigned int numThreads;
+    unsigned int expandersNumber = 1;
+    SchedulePolicy schedulePolicy = SchedulePolicy::Throughput;
+    SearchEngine searchEngine = SearchEngine::Recursive;
+    unsigned long long maxAnagrams = 0;                 //0 for no limit
+    std::chrono::duration<double> timeout{0.0};         //0 for no time budget
+    double checkpointPeriod = 0.0;                      //Seconds between two checkpoints, 0 for none
+    bool resume = false;                                //Continue the search of the checkpoint of the output file
+    int shardIndex = 1, shardsNumber = 1;               //This process searches shard 'shardIndex' out of 'shardsNumber'
+    size_t topNumber = 0;                               //Only the best 'topNumber' anagrams are kept, 0 to keep them all
+    std::string scoresFileName;                         //Scores of the words of a ranked search
+    WordScores wordScores;                              //Shared but read-only for threads
+    bool pinned = false;                                //Every worker is bound to a core, see pinWorker()
+    std::vector<int> workerCpus;                        //Cores the workers are bound to, in order
+    std::atomic<size_t> pinnedWorkers = 0;              //Workers bound so far☢️
 
     /***************SHARED RESOURCES***************/
 
-    //Thread-safe output queue
-    std::queue<std::string> anagramQueue;
-    std::mutex anagramQueueMutex;
-    std::condition_variable anagramQueueCV;
+    //Search workers, and the hook a running task gives a piece of itself away with. Empty outside of a search
+    WorkStealingPool* workerPool = nullptr;
+    std::function<void(const SearchTask&)> spawnTask;
+
+    //Signature solutions on their way from the search threads to the expanders
+    std::unique_ptr<SolutionPipeline> solutionPipeline;
+
+    //Lock-free output ring, of whole batches of anagrams
+    AnagramRing anagramRing;
+
+    //Best anagrams of a ranked search, written once the search is over. nullptr if every anagram is output
+    std::unique_ptr<TopAnagrams> topAnagrams;
+
+    //Cooperative cancellation, checked by the tasks, the search threads and the expanders
+    std::stop_source stopSource;
+    std::atomic<StopReason> stopReason = StopReason::None; //First reason that stopped the search☢️
+    static inline std::atomic<bool> interrupted = false;   //Set by the SIGINT handler☢️
 
     /*********************************************/
 
     //I/O
     std::atomic<bool> searchIsComplete = false; //Flag to signal I/O thread to stop☢️
+    std::atomic<std::chrono::steady_clock::time_point> ioDeadline; //When the parked I/O thread must be woken up by the watchdog, for the progress line or the checkpoint☢️
     std::ofstream ofstream;
+    uint64_t outputOffset = 0;                  //Bytes written to the output file
+    std::unique_ptr<Checkpoint> checkpoint;     //Progress saved by the I/O thread, nullptr if not checkpointing
     std::jthread ioThread;
 
     //Statistics
     unsigned long long anagramCount = 0;
     size_t setsNumber = 0;                       //Number of repeated combinations with sum found
     std::atomic<size_t> exploredSetsNumber = 0; //Progress index, incremented at the end of each search thread☢️
+    double totalCost = 0.0;                      //Sum of the estimated costs of all sets
+    std::atomic<double> exploredCost = 0.0;     //Estimated cost of the sets explored so far☢️
 
     //Private functions
     void print();                               //Debug print function
+    void printProgress(const std::string &currentAnagram); //Prints the progress line on the console
+    auto buildAlternatives(const std::vector<std::string> &texts, bool skipInvalid) -> std::expected<void, std::string>;
+    auto search(int workersNumber, int planWorkers, std::chrono::steady_clock::time_point startTime) -> std::expected<void, std::string>;
     void ioLoop(); //Thread that writes anagrams to file
+    auto nextDeadline(std::chrono::steady_clock::time_point lastDisplayTime,
+                      std::chrono::steady_clock::time_point lastCheckpointTime) const -> std::chrono::steady_clock::time_point;
+    auto checkpointInterval() const {return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(checkpointPeriod));}
+    void watchdogLoop(std::stop_token token, std::chrono::steady_clock::time_point startTime); //Turns timeouts and SIGINT into stop requests, wakes the I/O thread up on time
+    void requestStop(StopReason reason);
+    void saveCheckpoint(uint64_t offset, unsigned long long anagrams);
+    void writeTopAnagrams();
+    void pinWorker();                           //Binds the calling worker to its core, once
+    void replicateDictionary();                 //Gives every NUMA node its own copy of the dictionary, when pinned
+    size_t localNode() const;                   //Node of the calling thread, indexing the copies of the dictionary
+    const Dictionarium& nodeDictionary(size_t node) const {return (replicas.empty() || replicas[node] == nullptr) ? dictionary : *replicas[node];}
 };
 
 #endif
@@ -0,0 +1,69 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <expected>     //For std::expected
+#include <cstdint>     //For uint64_t, int64_t, SIZE_MAX
+#include <cstddef>    //For size_t
+#include <string>    //For std::string
+#include <vector>   //For std::vector
+#include <atomic>  //For std::atomic
+#include <map>    //For std::map
+
+#include "AnagramBatch.h"
+
+const double DEFAULT_CHECKPOINT_PERIOD = 5.0; //Seconds between two checkpoints when resuming without --checkpoint
+
+//What is left of a task: its search restarts from a first level entry, and skips the batches already written
+struct TaskProgress
+{
+    bool done = false;
+    size_t cursor = SIZE_MAX;                     //First level entry the search restarts from
+    uint64_t entryBase = 0;                       //Number of the first batch of that entry
+    uint64_t watermark = 0;                       //Every batch below it is written
+    std::map<uint64_t, BatchTag> ahead;           //Batches written above the watermark
+
+    bool isWritten(uint64_t seq) const {return seq < watermark || ahead.contains(seq);}
+};
+
+//Progress of a search, saved to a file every few seconds. The I/O thread records the batches of every task that
+//reached the output file; the workers record how many batches each finished task produced. A task is done when
+//its search is over and all of its batches are written
+class Checkpoint
+{
+public:
+    Checkpoint(const std::string &fileName, const std::string &query, int planWorkers);
+    Checkpoint() = delete;
+
+    //Reads a checkpoint, which must be of the same query. Its plan workers replace the current ones
+    auto load() -> std::expected<void, std::string>;
+
+    //Binds the checkpoint to the tasks of the schedule, given the first level entry each one starts from
+    auto attachTasks(const std::vector<size_t> &firstBegins) -> std::expected<void, std::string>;
+
+    //Writes the checkpoint to a temporary file, then renames it over the previous one. Called by the I/O thread
+    auto save(uint64_t outputOffset, unsigned long long anagramsNumber) -> std::expected<void, std::string>;
+
+    //Called by the I/O thread once all the anagrams of a batch are in the output file
+    void onWritten(const BatchTag &tag);
+
+    //Called by a worker when the search of a task is over, with the number of batches it produced
+    void onTaskFinished(size_t task, uint64_t batchesNumber);
+
+    //Getters
+    const TaskProgress& getProgress(size_t task) const;
+    uint64_t getOutputOffset() const;
+    unsigned long long getAnagramsNumber() const;
+    int getPlanWorkers() const;
+
+private:
+    const std::string fileName;
+    const std::string query;                     //Options the schedule depends on, a checkpoint is only valid for them
+    int planWorkers;                             //Workers the schedule was planned for, kept when resuming
+    uint64_t outputOffset = 0;
+    unsigned long long anagramsNumber = 0;
+
+    std::vector<TaskProgress> progress;                //Owned by the I/O thread
+    std::vector<std::atomic<int64_t>> finishedBatches; //Batches of every finished task, -1 while it runs☢️
+};
+
+#endif
@@ -7,10 +7,12 @@
 
 #include "ankerl/unordered_dense.h"
 #include "WordSignature.h"
+#include "WordFilter.h"
 
 //Every section of the dictionary is a map that associates a signature with 1 or more words
 //Section[i] only contains words of length i
 using Section = ankerl::unordered_dense::map<WordSignature, std::vector<std::string>>;
+using SectionEntry = Section::value_type; //Entries are stored contiguously, in insertion order
 
 const int MAX_WORD_LENGTH = 60; //If a word longer than 'maxWordLength' is found, program terminates
 
@@ -30,6 +32,22 @@ public:
     const std::vector<std::string>& getWords(const WordSignature &ws) const; //Returns the set of words associated to a signature
     const std::vector<int> getAvailableLengths() const;
 
+    //Drops every section whose length is not in 'lengths', they are of no use to the search
+    void restrictLengths(const std::vector<int> &lengths);
+
+    //Drops every section shorter than 'minLength' or longer than 'maxLength'
+    void restrictLengthRange(int minLength, int maxLength);
+
+    //Removes words, in any spelling with the same normalized form, and the signatures left without words. Moves the entries of the
+    //sections, so it must not be called while a search runs
+    void excludeWords(const std::vector<std::string> &words);
+
+    //Removes the words of a file, one per line. Returns the number of words removed
+    auto excludeWordList(const std::string &fileName) -> std::expected<unsigned long, std::string>;
+
+    //Words rejected by any of the filters are skipped by readWordList
+    void setWordFilters(const std::vector<WordFilter> &filters);
+
     //The source text is needed in order to exclude all words that are not a subset of it
     auto readWordList(const std::string &dictionaryName, const std::string &sourceText) -> std::expected<int, std::string>;
 
@@ -38,6 +56,7 @@ private:
     unsigned int actualWordsNumber;
     size_t longestWordLength;
     std::array<Section, MAX_WORD_LENGTH> sections;
+    std::vector<WordFilter> wordFilters;
 };
 
 #endif
@@ -0,0 +1,99 @@
+#ifndef LETTER_SEARCH_H
+#define LETTER_SEARCH_H
+
+#include <cstdint>         //For uint32_t
+#include <cstddef>        //For size_t
+#include <vector>        //For std::vector
+#include <array>        //For std::array
+#include <stop_token>  //For std::stop_token
+
+#include "WordSignature.h"
+#include "Dictionarium.h"
+#include "SetPlanner.h"
+#include "SolutionPipeline.h"
+#include "ArmaMagna.h"
+
+const size_t LETTERS_NUMBER = 26;
+const int LETTER_STOP_CHECK_NODES = 4096; //Candidates tried between two checks of the stop token
+
+//The entries that fit the target of a query, grouped by letter, for the letter engine. Every entry of the sections
+//not longer than the target has a global index, by increasing length and then in section order; the list of a letter
+//holds the indices of the fitting entries that contain it, in increasing order
+class LetterIndex
+{
+public:
+    LetterIndex(const Dictionarium &dictionary, const WordSignature &target, size_t query);
+
+    //Letters of the target, from the one the fewest entries contain
+    const std::vector<size_t>& getLetters() const {return letters;}
+
+    const std::vector<uint32_t>& getList(size_t letter) const {return lists[letter];}
+    const SectionEntry* getEntry(uint32_t index) const {return entries[index];}
+    uint32_t indexOf(const SectionEntry* entry) const;
+    size_t getQuery() const {return query;}
+
+    //Every entry of the list of the rarest letter is the root of a subtree, the tasks are ranges of them
+    std::vector<SearchTask> schedule(size_t set, double cost, int workersNumber, SchedulePolicy policy) const;
+
+private:
+    const Dictionarium &dictionary;
+    const size_t query;                                     //Query whose target the entries fit
+    std::array<uint32_t, MAX_WORD_LENGTH> offsets = {};     //Global index of the first entry of every section
+    std::vector<const SectionEntry*> entries;               //Every entry, by global index
+    std::array<std::vector<uint32_t>, LETTERS_NUMBER> lists;
+    std::vector<size_t> letters;
+};
+
+//Alternative search engine: no length sets, every step takes the rarest letter left in the remainder and tries the
+//words that contain it, of any length. Every multiset of signatures is found once: the word a letter was taken with
+//has the smallest index among the words of the solution that contain the letter, so the words placed later that
+//contain it can't have a smaller index
+class LetterSearch
+{
+public:
+    LetterSearch(ArmaMagna &armaMagna, const LetterIndex &index, const SearchTask &task);
+    void operator()();
+
+    //True if the search was cut short by a stop request
+    bool wasStopped() const {return stopped;}
+
+    //Estimated cost of what the task searched, without the pieces it gave away
+    double getCost() const {return cost;}
+
+private:
+    //Constructor arguments
+    ArmaMagna &armaMagna;                 //Reference to the friend armaMagna object, needed to access the pipeline
+    const LetterIndex &index;
+    const SearchQuery &query;
+    const size_t set;
+    const size_t firstBegin;             //Range of the list of the first letter to explore
+    size_t firstEnd;
+    double cost;
+
+    //Per-depth state
+    std::vector<WordSignature> remainders;              //remainders[d] is what is left of the target after d words
+    std::vector<std::array<uint32_t, LETTERS_NUMBER>> minIndices; //Smallest index a word containing a letter can have
+    std::vector<const SectionEntry*> solution;
+    std::vector<const SectionEntry*> ordered;           //Solution sorted, so that repeated signatures are consecutive
+    int maxDepth;
+
+    //Work stealing, see split()
+    bool splittable = false;
+    size_t firstCursor = 0;                             //Next entry of the first letter's list
+
+    //Cooperative cancellation
+    std::stop_token stopToken;
+    int stopCountdown = LETTER_STOP_CHECK_NODES;
+    bool stopped = false;
+
+    std::vector<SignatureBatch> batches;                //Pending solutions, one batch per number of words
+
+    void search(int depth);
+    void tryEntry(int depth, size_t letter, uint32_t entryIndex);
+    bool pollStop();
+    void split(bool inSubtree);
+    void emitSolution(int width);
+    void flushSolutions(int width);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PAIR_SUM_TABLES_H
+#define PAIR_SUM_TABLES_H
+
+#include <cstdint>     //For uint32_t
+#include <cstddef>    //For size_t
+#include <memory>    //For std::unique_ptr
+#include <atomic>   //For std::atomic
+#include <vector>  //For std::vector
+#include <array>  //For std::array
+#include <mutex> //For std::once_flag, std::call_once
+
+#include "ankerl/unordered_dense.h"
+#include "WordSignature.h"
+#include "Dictionarium.h"
+
+const size_t PAIR_TABLES_MEMORY_CAP = 512ull << 20; //Bytes shared by all the tables of every node, above it the search falls back to the normal scan
+
+//Indices of two entries, in the sections of the first and of the second length of the pair
+struct EntryPair
+{
+    uint32_t first, second;
+};
+
+//Maps the sum of the signatures of two entries to every pair of entries with that sum
+using PairSumTable = ankerl::unordered_dense::map<WordSignature, std::vector<EntryPair>>;
+
+//Meet-in-the-middle tables for the last two levels of a set, one per ordered pair of lengths.
+//Built lazily by the first worker that needs them, then shared read-only by all the workers
+class PairSumTables
+{
+public:
+    PairSumTables(const Dictionarium &dictionary, const WordSignature &bound, std::atomic<size_t> &usedMemory);
+    PairSumTables() = delete;
+
+    //Returns the table of the pair of lengths, building it if needed. Returns nullptr if it doesn't fit the memory cap
+    const PairSumTable* get(int firstLength, int secondLength);
+
+private:
+    const Dictionarium &dictionary;
+    const WordSignature bound;               //Only the sums that are a subset of it are stored
+    std::atomic<size_t> &usedMemory;         //Bytes reserved by the tables built so far, or being built, shared by the copies on every node☢️
+
+    std::array<std::array<std::once_flag, MAX_WORD_LENGTH>, MAX_WORD_LENGTH> builtFlags;
+    std::array<std::array<std::unique_ptr<PairSumTable>, MAX_WORD_LENGTH>, MAX_WORD_LENGTH> tables;
+
+    void build(int firstLength, int secondLength);
+};
+
+#endif
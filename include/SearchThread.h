@@ -1,33 +1,123 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
-#include <string>          //For std::string
+#include <cstdint>         //For uint64_t
 #include <vector>         //For std::vector
+#include <stop_token>    //For std::stop_token
 
 #include "ankerl/unordered_dense.h"
 #include "WordSignature.h"
+#include "PairSumTables.h"
+#include "TranspositionTable.h"
+#include "SolutionPipeline.h"
+#include "Checkpoint.h"
 #include "ArmaMagna.h"
 
+const int STOP_CHECK_NODES = 4096; //Candidates tried between two checks of the stop token
+
+//Per-depth state of the search, a cursor over the candidate list of a level
+struct LevelCursor
+{
+    const SectionEntry* const* current = nullptr; //Next candidate to try
+    const SectionEntry* const* end = nullptr;     //One past the last candidate
+};
+
+//Solutions found below a depth, recorded to be stored in the transposition table when the depth is closed
+struct MemoRecording
+{
+    bool active = false;        //True while the subproblem of the depth is being searched
+    bool overflow = false;      //Too many completions to be worth storing
+    SubproblemKey key;
+    Completions completions;
+};
+
 class SearchThread
 {
 public:
-    SearchThread(ArmaMagna &armaMagna, const std::vector<int>& wordLengths);
+    SearchThread(ArmaMagna &armaMagna, const PlannedSet& plannedSet, const SearchTask& task, const TaskProgress* resume);
     void operator()();
 
+    //True if the search was cut short by a stop request, its slice isn't fully explored
+    bool wasStopped() const {return stopped;}
+
+    //Number of signature batches the task produced, written or not
+    uint64_t getBatchesNumber() const {return nextSeq;}
+
+    //Estimated cost of what the task searched, without the pieces it gave away
+    double getCost() const {return cost;}
+
 private:
     //Constructor arguments
     ArmaMagna &armaMagna;                 //Reference to the friend armaMagna object, needed to access its dictionary and the anagram list
-    const std::vector<int> wordLengths;  //Vector of integers generated by PowerSet, every int represents a word length
+    const std::vector<int> wordLengths;  //Vector of integers generated by PowerSet, every int represents a word length, walked in the order chosen by SetPlanner
+    const SearchQuery &query;            //Query the set belongs to, its target is what the words must add up to
+    const size_t set;                    //Index of the set in the planned sets
+    const size_t firstBegin;             //Range of entries of the first section to explore, the whole section unless the set is sliced
+    size_t firstEnd;                     //or the task gave its end away, see split()
+    const size_t secondBegin, secondEnd; //Same for the second section, SIZE_MAX for the end of the section
+    const size_t taskId;                 //Position of the task in the schedule
+    const TaskProgress* resume;          //What a previous run already wrote of the task, nullptr if it's a new search
+    double cost;                         //Estimated cost of the task
+    const size_t node;                   //NUMA node the search runs on
+    const Dictionarium &dictionary;      //Copy of the dictionary of the node, see ArmaMagna::nodeDictionary()
 
     //Other variables
     int wordsNumber;                               //Number of words of which the anagram will be made of
-    WordSignature ws;                             //Dummy signature, used in the recursive search algorithm
-    std::vector<WordSignature> solution;         //Array of pointers to a signature, will contain the pointers to signatures that make a solution
-    ankerl::unordered_dense::set<std::string> anagramSet; //Local collection of anagrams found by this search thread
+    int lastLevel;                                //Index of the last level, resolved by a lookup
+    int listedLevels;                            //Levels below it get candidate lists, the others are resolved by lookups
+    const PairSumTable* pairTable = nullptr;    //Pair-sum table of the last two levels, if available
+    std::vector<WordSignature> remainders;        //remainders[d] is what is left of the target after the first d levels
+    std::vector<const SectionEntry*> solution;   //Array of pointers to an entry, will contain the pointers to the entries that make a solution
+    std::vector<LevelCursor> cursors;           //Per-depth cursors, sized once to the number of words
+
+    //candidates[d*wordsNumber + j] holds the entries of level j (d <= j < lastLevel) that fit remainders[d], in section order
+    //candidates[lastLevel*wordsNumber + lastLevel] holds the entry equal to the last remainder, if any
+    std::vector<std::vector<const SectionEntry*>> candidates;
+    std::vector<const SectionEntry*>& candidateList(int depth, int level) {return candidates[depth * wordsNumber + level];}
+
+    //Transposition table state
+    std::vector<uint64_t> suffixKeys;            //Packed lengths left at every depth, in level order, 0 if the depth isn't memoized
+    std::vector<MemoRecording> recordings;      //Per-depth recordings of the solutions
+    Completions memoHit;                        //Completions of the last subproblem found in the table
+
+    //Branch and bound of a ranked search, see canRank()
+    bool ranking = false;                       //True if only the top anagrams are wanted
+    std::vector<double> prefixScores;           //prefixScores[d] is the best score of the first d levels, included text first
+    std::vector<double> suffixBounds;           //suffixBounds[d] is the best score the levels from d onwards can add
 
+    //Work stealing, see split()
+    bool splittable = false;                    //True if the task may give pieces away to idle workers
+    double entryCost = 0.0;                     //Estimated cost of a first level candidate
+
+    //Cooperative cancellation, the stop token is polled every STOP_CHECK_NODES candidates
+    std::stop_token stopToken;
+    int stopCountdown = STOP_CHECK_NODES;
+    bool stopped = false;
+
+    //Signature solutions not yet handed to the expansion pipeline, numbered for the checkpoints
+    SignatureBatch signatureBatch;
+    uint64_t nextSeq = 0;                       //Number of the next batch of the task
+    uint64_t entryBase = 0;                     //Number of the first batch of the current first level entry
+    const SectionEntry* batchEntry = nullptr;   //First level entry of the solutions in the batch
+
+    void explore();               //Builds the first candidate lists and runs the engine
     void search(int wordIndex);   //Main function, core of the program
-    void computeSolution();
-    void outputSolution(std::vector<std::string> &unorderedAnagram, int index);
+    void searchIterative();       //Non-recursive engine, same results as search()
+    void openLevel(int wordIndex);
+    bool nextEntry(int wordIndex);
+    bool pollStop();
+    void split(int wordIndex);
+    bool canRank(int wordIndex, const SectionEntry* entry);
+    bool filterCandidates(int wordIndex, const SectionEntry* entry);
+    bool lookupLastLevel();
+    bool lookupPairs();
+    bool inSlice(int level, const SectionEntry* entry) const;
+    bool probeMemo(int depth);
+    void closeLevel(int depth);
+    void onSolution();
+
+    void emitSolution();                     //Appends the solution to the batch, hands the batch to the pipeline when full
+    void flushSolutions(bool lastOfEntry);   //Hands the pending solutions to the pipeline
 };
 
 #endif
@@ -0,0 +1,93 @@
+#ifndef SET_PLANNER_H
+#define SET_PLANNER_H
+
+#include <cstddef>   //For size_t
+#include <vector>   //For std::vector
+#include <array>   //For std::array
+
+#include "ankerl/unordered_dense.h"
+#include "WordSignature.h"
+#include "Dictionarium.h"
+
+const int FIRST_RESULTS_GRANULES = 16; //In first results mode, no task costs more than 1/16 of a worker's share of the search
+const int THROUGHPUT_GRANULES = 4;     //In throughput mode, no task costs more than 1/4 of a worker's share of the search
+const int SHARD_PLAN_WORKERS = 16;     //Workers per shard the tasks are cut for, so that every shard plans the same tasks
+
+//A length set ready to be dispatched to the thread pool, along with its estimated search cost
+struct PlannedSet
+{
+    size_t index;                 //Index of the set in RepeatedCombinationsWithSum
+    std::vector<int> wordLengths; //Word lengths the search thread will walk through
+    double cost;                  //Estimated number of nodes the search will visit
+    size_t query = 0;             //Query whose target the set adds up to
+};
+
+//Unit of work posted to the thread pool: a length set, or a slice of its first one or two levels
+struct SearchTask
+{
+    size_t set;                                     //Index of the set in the planned sets
+    size_t firstBegin, firstEnd;                    //Range of first level entries to explore
+    size_t secondBegin, secondEnd;                  //Range of second level entries to explore, SIZE_MAX if the whole level
+    double cost;                                    //Estimated cost of the slice
+    size_t id = 0;                                  //Position of the task in the schedule
+};
+
+//Dispatch policies of the length sets
+enum class SchedulePolicy
+{
+    Throughput,   //Largest sets first (LPT), minimizes the total search time
+    FirstResults  //Cheapest sets first, cut into small slices, minimizes the time to the first anagrams
+};
+
+//Per-length statistics of a dictionary section, computed against the actual target
+struct SectionStats
+{
+    size_t filteredSize = 0;  //Number of signatures in the section that are a subset of the actual target
+    WordSignature minUsage;  //Letters that every filtered signature of the section uses, letter by letter minimum
+    WordSignature maxUsage; //Letter by letter maximum over the filtered signatures of the section
+};
+
+class SetPlanner
+{
+public:
+    SetPlanner(const Dictionarium &dictionary, const WordSignature &target);
+    SetPlanner() = delete;
+
+    //Cost model, estimates the number of nodes visited by SearchThread on a length set
+    double estimateCost(const std::vector<int> &wordLengths) const;
+
+    //Level order optimizer, returns the levels of the set in the order SearchThread should walk them
+    std::vector<int> orderLevels(const std::vector<int> &wordLengths) const;
+
+    //Letter reachability pre-pass, false if the length set can never produce an anagram of the actual target
+    bool isFeasible(const std::vector<int> &wordLengths);
+
+    //Turns the planned sets into the ordered list of tasks to post, according to the policy. The sets are sliced against
+    //the cost of the whole search, 'searchCost', which is the cost of the sets themselves if 0
+    std::vector<SearchTask> schedule(const std::vector<PlannedSet> &plannedSets, SchedulePolicy policy, int workersNumber, double searchCost = 0.0) const;
+
+    //Sorts the tasks in the order of the policy and numbers them, ties keep their order
+    static void order(std::vector<SearchTask> &tasks, SchedulePolicy policy);
+
+    //Cuts a set into about 'pieces' tasks of similar cost, slicing its first level, or its first two levels if the first
+    //one is too small. The tasks are deterministic, they only depend on the dictionary and the target
+    void split(const PlannedSet &plannedSet, size_t set, size_t pieces, std::vector<SearchTask> &tasks) const;
+
+    //Deterministic cost-balanced subset of the tasks for shard 'shardIndex' (1-based) of 'shardsNumber', in schedule order
+    static std::vector<SearchTask> shard(const std::vector<SearchTask> &tasks, int shardIndex, int shardsNumber);
+
+    //Getters
+    const SectionStats& getStats(int length) const;
+
+private:
+    const WordSignature target;
+    const int targetLength;
+    std::array<SectionStats, MAX_WORD_LENGTH> stats;
+    const Dictionarium &dictionary;
+
+    //Memo of the section scans done by isFeasible, keyed by length and residual target
+    std::array<ankerl::unordered_dense::map<WordSignature, bool>, MAX_WORD_LENGTH> fitsMemo;
+    bool sectionFits(int length, const WordSignature &residual);
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef SOLUTION_PIPELINE_H
+#define SOLUTION_PIPELINE_H
+
+#include <condition_variable>  //For std::condition_variable
+#include <string_view>        //For std::string_view
+#include <cstddef>           //For size_t
+#include <string>           //For std::string
+#include <vector>          //For std::vector
+#include <thread>         //For std::jthread
+#include <queue>         //For std::queue
+#include <mutex>        //For std::mutex
+#include <span>        //For std::span
+
+#include "Dictionarium.h"
+#include "AnagramBatch.h"
+
+class ArmaMagna;
+struct Alternative;
+
+const size_t SIGNATURE_BATCH_TUPLES = 256; //Signature solutions a search thread gathers before handing them to the pipeline
+const size_t PIPELINE_CAPACITY = 1024;     //Batches the pipeline holds before the search threads wait for the expanders
+
+//Signature solutions of a set, stored flat: every tuple is 'width' consecutive entries, one per level
+struct SignatureBatch
+{
+    int width = 0;
+    size_t query = 0;                          //Query of the set, its alternatives get one anagram each per tuple
+    const Dictionarium* dictionary = nullptr;  //Copy of the dictionary the entries point into
+    BatchTag tag;
+    std::vector<const SectionEntry*> entries;
+
+    size_t size() const {return (width > 0) ? entries.size() / static_cast<size_t>(width) : 0;}
+};
+
+//Second stage of the search: the search threads only find tuples of signatures, a separate pool of expanders turns
+//them into the Cartesian product of their words and pushes the anagrams to the I/O queue, or offers them to the top
+//anagrams in a ranked search
+class SolutionPipeline
+{
+public:
+    SolutionPipeline(ArmaMagna &armaMagna, int expandersNumber);
+    SolutionPipeline() = delete;
+    ~SolutionPipeline();
+
+    //Hands a batch to the expanders, waits while the pipeline is full
+    void push(SignatureBatch &&batch);
+
+    //Signals that no more batches will come, and waits for the expanders to drain the pipeline
+    void close();
+
+private:
+    ArmaMagna &armaMagna;                 //Reference to the friend armaMagna object, needed to access the I/O queue
+
+    std::queue<SignatureBatch> batches;
+    std::mutex batchesMutex;
+    std::condition_variable notEmptyCV, notFullCV;
+    bool closed = false;
+
+    std::vector<std::jthread> expanders;
+
+    //Scratch space of an expander thread, reused for every tuple
+    struct ExpanderState
+    {
+        std::vector<std::string> anagram;          //Words of the anagram being expanded, included text first
+        std::vector<std::string_view> ordered;     //Same words, sorted for the output
+        std::vector<size_t> wordCursors;           //Index of the word currently expanded at every level
+        std::vector<const std::vector<double>*> wordScores; //Scores of the words of every level, for a ranked search
+        std::vector<double> tupleBounds;           //tupleBounds[i] is the best score the levels from i onwards can add
+        AnagramBatch anagrams;                     //Anagrams not yet handed to the I/O thread
+        const Alternative* alternative = nullptr;  //Alternative of the anagrams being expanded
+        const Dictionarium* dictionary = nullptr;  //Copy of the dictionary of the batch being expanded
+    };
+
+    void expanderLoop();
+    void expand(std::span<const SectionEntry* const> tuple, const Alternative &alternative, ExpanderState &state);
+    void expandRecursive(std::span<const SectionEntry* const> tuple, ExpanderState &state, size_t index, size_t firstWord);
+    void expandIterative(std::span<const SectionEntry* const> tuple, ExpanderState &state);
+    void expandTop(std::span<const SectionEntry* const> tuple, ExpanderState &state, size_t index, size_t firstWord, double score);
+    void pushAnagram(ExpanderState &state);
+    void flushAnagrams(ExpanderState &state);
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TOP_ANAGRAMS_H
+#define TOP_ANAGRAMS_H
+
+#include <cstddef>    //For size_t
+#include <string>    //For std::string
+#include <vector>   //For std::vector
+#include <atomic>  //For std::atomic
+#include <mutex>  //For std::mutex
+#include <cmath> //For std::abs
+
+const double SCORE_TOLERANCE = 1e-9; //Relative slack of the score bounds, sums in a different order may round differently
+
+//An anagram and its score
+struct ScoredAnagram
+{
+    double score;
+    std::string text;
+
+    //Ranking order: higher score first, then alphabetical, so that the K best are the same on every run
+    bool operator<(const ScoredAnagram &other) const
+    {
+        if(score != other.score) return score > other.score;
+        return text < other.text;
+    }
+};
+
+//The K best anagrams found so far, in a bounded heap shared by the expanders. Its threshold, the score of the worst
+//anagram kept once the heap is full, is published through an atomic so that the search threads can prune with it
+class TopAnagrams
+{
+public:
+    explicit TopAnagrams(size_t capacity);
+    TopAnagrams() = delete;
+
+    //Keeps the anagram if it ranks among the K best, returns true if it was kept
+    bool offer(double score, std::string &&text);
+
+    //Score a branch must reach to matter, -infinity until the heap is full
+    double getThreshold() const {return threshold.load(std::memory_order_relaxed);}
+
+    //True if a branch whose best score is 'bound' may still rank
+    bool canReach(double bound) const
+    {
+        const double t = getThreshold();
+        return bound >= t - SCORE_TOLERANCE * (1.0 + std::abs(t));
+    }
+
+    //The anagrams kept, best first
+    std::vector<ScoredAnagram> getSorted() const;
+
+private:
+    const size_t capacity;
+    std::vector<ScoredAnagram> heap; //Max-heap on the ranking order, so its front is the worst anagram kept
+    mutable std::mutex heapMutex;
+    std::atomic<double> threshold;   //☢️
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <vector> //For std::vector
+
+//CPUs and NUMA nodes of the machine. Without libnuma (ARMAMAGNA_NUMA) every CPU is on node 0, and outside of Linux
+//threads can't be pinned
+namespace Topology
+{
+    //CPUs the process may run on, in increasing order
+    std::vector<int> allowedCpus();
+
+    //Binds the calling thread to a CPU. Returns false if it can't be done
+    bool pinCurrentThread(int cpu);
+
+    //Number of NUMA nodes with memory, at least 1
+    int nodesNumber();
+
+    //Node of a CPU, 0 if unknown
+    int nodeOfCpu(int cpu);
+
+    //Node of the CPU the calling thread runs on
+    int currentNode();
+
+    //Moves the calling thread to the CPUs of a node, and makes it allocate there. Returns false if it can't be done
+    bool runOnNode(int node);
+};
+
+#endif
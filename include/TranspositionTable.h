@@ -0,0 +1,80 @@
+#ifndef TRANSPOSITION_TABLE_H
+#define TRANSPOSITION_TABLE_H
+
+#include <cstdint>    //For uint32_t, uint64_t
+#include <cstddef>   //For size_t
+#include <vector>   //For std::vector
+#include <array>   //For std::array
+#include <mutex>  //For std::mutex
+
+#include "ankerl/unordered_dense.h"
+#include "WordSignature.h"
+
+const size_t TRANSPOSITION_TABLE_MEMORY_CAP = 256ull << 20; //Bytes of the recorded subproblems, split evenly between the shards
+const size_t TRANSPOSITION_TABLE_SHARDS = 64;               //Independent locks, to keep the workers from contending
+const size_t MAX_MEMO_COMPLETIONS = 32;                     //Subproblems with more completions are not recorded
+
+//A subproblem of the search: what is left of the target, and the lengths left to place, in the order of their levels
+//The lengths are packed 6 bits each, so at most 10 of them fit
+struct SubproblemKey
+{
+    WordSignature remainder;
+    uint64_t lengths;
+
+    bool operator==(const SubproblemKey &other) const = default;
+};
+
+struct SubproblemKeyHash
+{
+    using is_avalanching = void;
+    size_t operator()(const SubproblemKey &key) const noexcept
+    {
+        return std::hash<WordSignature>{}(key.remainder) ^ (key.lengths * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+//Completions of a subproblem, every completion is a run of packed entries, one per length left
+//An empty list means the subproblem has no solution
+using Completions = std::vector<uint32_t>;
+
+//Packs an entry as its length (high 8 bits) and its index in the section (low 24 bits)
+inline uint32_t packEntry(int length, size_t index) {return (static_cast<uint32_t>(length) << 24) | static_cast<uint32_t>(index);}
+inline int packedLength(uint32_t packed) {return static_cast<int>(packed >> 24);}
+inline size_t packedIndex(uint32_t packed) {return packed & 0xFFFFFF;}
+
+//Concurrent, bounded memo of the subproblems solved by the search threads, shared by all the length sets
+//A shard over its share of the memory cap is simply cleared, the table is a cache and forgetting is always correct.
+//The bytes counted are the capacities of the map and of the completion lists, so the table never holds more than
+//TRANSPOSITION_TABLE_MEMORY_CAP, plus the growth of a shard's map while it's being reallocated
+class TranspositionTable
+{
+public:
+    TranspositionTable() = default;
+
+    //Copies the completions of the subproblem in 'completions' and returns true if it's recorded
+    bool probe(const SubproblemKey &key, Completions &completions);
+    void store(const SubproblemKey &key, const Completions &completions);
+
+    //Forgets every subproblem, not thread-safe
+    void clear();
+
+private:
+    struct Shard
+    {
+        using Records = ankerl::unordered_dense::map<SubproblemKey, Completions, SubproblemKeyHash>;
+
+        std::mutex mutex;
+        Records records;
+        size_t completionsMemory = 0; //Bytes of the completion lists of the records
+
+        size_t memory() const
+        {
+            return records.values().capacity() * sizeof(Records::value_type) + records.bucket_count() * sizeof(Records::bucket_type) + completionsMemory;
+        }
+    };
+    std::array<Shard, TRANSPOSITION_TABLE_SHARDS> shards;
+
+    Shard& shardOf(const SubproblemKey &key);
+};
+
+#endif
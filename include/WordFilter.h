@@ -0,0 +1,35 @@
+#ifndef WORD_FILTER_H
+#define WORD_FILTER_H
+
+#include <string_view>  //For std::string_view
+#include <expected>    //For std::expected
+#include <cstdint>    //For int32_t
+#include <string>    //For std::string
+#include <vector>   //For std::vector
+#include <array>   //For std::array
+
+const size_t MAX_FILTER_STATES = 4096;      //A pattern whose automaton grows beyond it is rejected
+const size_t MAX_FILTER_NFA_STATES = 16384; //Same for the NFA it's built from, bounded repeats copy their pattern
+
+//A word pattern compiled once into a DFA over the bytes of the word, as written in the dictionary.
+//Patterns are regular expressions, each top level branch searched anywhere in the word unless anchored with ^ and $:
+//literals, ., [...], [^...], ranges, groups, |, *, +, ?, {m}, {m,}, {m,n} and \ escapes. 'glob:' patterns are shell globs matching the
+//whole word (*, ?, [...], [!...]). A leading '!' keeps the words that don't match
+class WordFilter
+{
+public:
+    static auto compile(const std::string &pattern) -> std::expected<WordFilter, std::string>;
+
+    //True if the word passes the filter
+    bool accepts(std::string_view word) const;
+
+private:
+    WordFilter() = default;
+
+    std::vector<std::array<int32_t, 256>> transitions; //Next state for every byte, -1 if no match is possible anymore
+    std::vector<bool> accepting;
+    bool anchoredEnd = false;                          //Without any $, the word matches as soon as a match ends
+    bool negated = false;
+};
+
+#endif
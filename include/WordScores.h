@@ -0,0 +1,42 @@
+#ifndef WORD_SCORES_H
+#define WORD_SCORES_H
+
+#include <expected>    //For std::expected
+#include <cstddef>    //For size_t
+#include <string>    //For std::string
+#include <vector>   //For std::vector
+#include <array>   //For std::array
+
+#include "ankerl/unordered_dense.h"
+#include "Dictionarium.h"
+
+//Per-word scores (e.g. frequencies) read from a file, and their tables over the dictionary entries, used to rank the
+//anagrams and to bound the score of a branch of the search. The score of an anagram is the sum of its words' scores
+class WordScores
+{
+public:
+    WordScores() = default;
+
+    //Every line is a word followed by its score, separated by whitespace. Returns the number of scores read
+    auto readScores(const std::string &fileName) -> std::expected<size_t, std::string>;
+
+    //Score of a word, 0 if the file doesn't list it
+    double getScore(const std::string &word) const;
+
+    //Builds the tables of the entries of the dictionary, whose sections must not change afterwards
+    void indexDictionary(const Dictionarium &dictionary);
+
+    //Getters of the tables, an entry is given by its length and its index in the section, the same in every copy of the dictionary
+    const std::vector<double>& getWordScores(int length, size_t index) const {return wordScores[length][index];}
+    double getEntryBest(int length, size_t index) const {return entryBest[length][index];}
+    double getSectionBest(int length) const {return sectionBest[length];}
+
+private:
+    ankerl::unordered_dense::map<std::string, double> scores;
+
+    std::array<std::vector<std::vector<double>>, MAX_WORD_LENGTH> wordScores; //Scores of the words of every entry
+    std::array<std::vector<double>, MAX_WORD_LENGTH> entryBest;               //Best word score of every entry
+    std::array<double, MAX_WORD_LENGTH> sectionBest = {};                     //Best word score of every section
+};
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <condition_variable>  //For std::condition_variable
+#include <functional>         //For std::function
+#include <cstddef>           //For size_t
+#include <memory>           //For std::unique_ptr
+#include <atomic>          //For std::atomic
+#include <thread>         //For std::jthread
+#include <vector>        //For std::vector
+#include <deque>        //For std::deque
+#include <mutex>       //For std::mutex
+
+//Thread pool with a deque per worker. Tasks posted from outside go to a shared queue, in order; tasks spawned by a
+//running task go to the deque of its worker. A worker takes the newest task of its own deque, then the oldest of the
+//shared queue, then steals the oldest task of another worker, so thieves take the biggest pieces of a split task
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int workersNumber);
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    ~WorkStealingPool();
+
+    //Queues a task on the shared queue
+    void post(std::function<void()> task);
+
+    //Queues a task on the deque of the calling worker, where the others can steal it. Outside of a worker, same as post()
+    void spawn(std::function<void()> task);
+
+    //True if a worker is idle and no queued task is left for it, a running task may then split itself
+    bool wantsWork() const {return idleWorkers.load(std::memory_order_relaxed) > queuedTasks.load(std::memory_order_relaxed);}
+
+    //Waits until every task is done, the spawned ones included, then stops the workers
+    void join();
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::deque<std::function<void()>> sharedTasks; //Guarded by 'mutex'
+
+    std::mutex mutex;                              //Guards the shared queue, sleeping and stopping
+    std::condition_variable workCV, doneCV;
+    std::atomic<size_t> queuedTasks = 0;           //Tasks waiting in any queue, only incremented under 'mutex'☢️
+    std::atomic<size_t> pendingTasks = 0;          //Tasks queued or running☢️
+    std::atomic<size_t> idleWorkers = 0;           //Workers sleeping on 'workCV'☢️
+    bool stopping = false;
+
+    std::vector<std::jthread> threads;
+
+    void workerLoop(size_t index);
+    bool take(size_t index, std::function<void()> &task);
+    void enqueue(Worker* worker, std::function<void()> &&task);
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include <string_view>  //For std::string_view
+#include <cassert>      //For assert
+#include <cstring>     //For std::memcpy
+#include <cstdint>    //For uint32_t
+#include <vector>    //For std::vector
+
+#include "AnagramBatch.h"
+
+//The length prefix is reserved first, and patched once the words are written
+void AnagramBatch::append(const std::vector<std::string_view> &words, std::string_view tag)
+{
+    assert(!words.empty());
+
+    lastOffset = buffer.size();
+    buffer.append(sizeof(uint32_t), '\0');
+    if(!tag.empty()) {buffer += tag; buffer += '\t';}
+    for(const std::string_view word : words) {buffer += word; buffer += ' ';}
+    buffer.pop_back(); //Trailing space is removed
+
+    const uint32_t length = static_cast<uint32_t>(buffer.size() - lastOffset - sizeof(uint32_t));
+    std::memcpy(buffer.data() + lastOffset, &length, sizeof(uint32_t));
+    count++;
+}
+
+std::string_view AnagramBatch::next(size_t &offset) const
+{
+    assert(offset + sizeof(uint32_t) <= buffer.size());
+    uint32_t length;
+    std::memcpy(&length, buffer.data() + offset, sizeof(uint32_t));
+
+    const std::string_view entry(buffer.data() + offset + sizeof(uint32_t), length);
+    offset += sizeof(uint32_t) + length;
+    return entry;
+}
+
+std::string_view AnagramBatch::last() const
+{
+    if(empty()) return {};
+    size_t offset = lastOffset;
+    return next(offset);
+}
+
+void AnagramBatch::clear()
+{
+    buffer.clear();
+    count = 0;
+    lastOffset = 0;
+    tags.clear();
+}
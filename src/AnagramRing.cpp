@@ -0,0 +1,100 @@
+#include <cstdint>   //For uint32_t
+#include <cstddef>  //For size_t
+#include <memory>  //For std::unique_ptr
+#include <atomic> //For std::atomic
+
+#include "AnagramRing.h"
+
+static_assert((ANAGRAM_RING_CAPACITY & (ANAGRAM_RING_CAPACITY - 1)) == 0, "The ring capacity must be a power of two");
+
+AnagramRing::AnagramRing()
+{
+    //Slot i is free for the producer that claims position i
+    for(size_t i=0; i<ANAGRAM_RING_CAPACITY; i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+AnagramRing::~AnagramRing()
+{
+    while(pop() != nullptr) {} //Batches never consumed are freed
+}
+
+//The published counter is bumped after the slot, so a consumer parking on its old value either sees the batch on its
+//last check, or is woken up by the bump
+void AnagramRing::push(std::unique_ptr<AnagramBatch> batch)
+{
+    AnagramBatch* raw = batch.release();
+    bool pushed = tryPush(raw);
+    while(!pushed)
+    {
+        //Full ring: parks until the consumer frees a slot, the same ordering argument applies to 'freed'
+        producersParked.fetch_add(1);
+        const uint32_t lastFreed = freed.load();
+        pushed = tryPush(raw);
+        if(!pushed) freed.wait(lastFreed);
+        producersParked.fetch_sub(1);
+    }
+
+    published.fetch_add(1);
+    if(consumerParked.load()) published.notify_one();
+}
+
+bool AnagramRing::tryPush(AnagramBatch* batch)
+{
+    size_t position = tail.load(std::memory_order_relaxed);
+    while(true)
+    {
+        Slot &slot = slots[position & (ANAGRAM_RING_CAPACITY - 1)];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if(difference == 0) //Free slot for this lap, claims it
+        {
+            if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                slot.batch = batch;
+                slot.sequence.store(position + 1, std::memory_order_release); //Published
+                return true;
+            }
+        }
+        else if(difference < 0) return false;                        //Not consumed yet since the last lap, full
+        else                    position = tail.load(std::memory_order_relaxed); //Claimed by another producer
+    }
+}
+
+std::unique_ptr<AnagramBatch> AnagramRing::pop()
+{
+    Slot &slot = slots[head & (ANAGRAM_RING_CAPACITY - 1)];
+    if(slot.sequence.load(std::memory_order_acquire) != head + 1) return nullptr; //Not published yet
+
+    std::unique_ptr<AnagramBatch> batch(slot.batch);
+    slot.sequence.store(head + ANAGRAM_RING_CAPACITY, std::memory_order_release); //Free for the next lap
+    head++;
+
+    freed.fetch_add(1);
+    if(producersParked.load() > 0) freed.notify_all();
+    return batch;
+}
+
+bool AnagramRing::empty() const
+{
+    return slots[head & (ANAGRAM_RING_CAPACITY - 1)].sequence.load(std::memory_order_acquire) != head + 1;
+}
+
+void AnagramRing::waitForBatch(const std::atomic<bool> &done)
+{
+    for(int i=0; i<ANAGRAM_RING_SPINS; i++)
+    {
+        if(!empty() || done.load()) return;
+    }
+
+    consumerParked.store(true);
+    const uint32_t lastPublished = published.load();
+    if(empty() && !done.load()) published.wait(lastPublished);
+    consumerParked.store(false);
+}
+
+void AnagramRing::wake()
+{
+    published.fetch_add(1);
+    published.notify_one();
+}
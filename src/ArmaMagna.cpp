@@ -1,22 +1,32 @@
-#include <iostream>  //For I/O
-#include <expected>  //For std::expected, std::unexpected
-#include <memory>    //For std::make_unique, std::unique_ptr
-#include <string>    //For std::string
-#include <vector>    //For std::vector
-#include <chrono>    //For std::chrono
-#include <ranges>    //For std::views, std::ranges::distance
-#include <format>    //For std::format
-#include <print>     //For std::print
+#include <iostream>           //For I/O
+#include <expected>           //For std::expected, std::unexpected
+#include <memory>             //For std::make_unique, std::unique_ptr
+#include <string>             //For std::string
+#include <string_view>        //For std::string_view
+#include <vector>             //For std::vector
+#include <chrono>             //For std::chrono
+#include <mutex>              //For std::mutex, std::unique_lock
+#include <condition_variable> //For std::condition_variable_any
+#include <stop_token>         //For std::stop_token
+#include <filesystem>         //For std::filesystem::file_size, std::filesystem::resize_file
+#include <ranges>             //For std::views, std::ranges::distance
+#include <limits>             //For std::numeric_limits
+#include <algorithm>          //For std::min, std::ranges::contains, std::ranges::find, std::ranges::count, std::ranges::count_if, std::ranges::stable_sort, std::ranges::max_element
+#include <format>             //For std::format
+#include <print>              //For std::print
 
 #include "WordSignature.h"
 #include "Dictionarium.h"
 #include "StringNormalizer.h"
 #include "Combinations.h"
+#include "SetPlanner.h"
 #include "SearchThread.h"
+#include "LetterSearch.h"
+#include "SolutionPipeline.h"
+#include "Checkpoint.h"
+#include "Topology.h"
 #include "ArmaMagna.h"
 
-#include <boost/asio.hpp>
-
 int countWords(const std::string &str); //Counts words in a string
 
 //Constructor
@@ -26,13 +36,13 @@ ArmaMagna::ArmaMagna()
 }
 
 auto ArmaMagna::setOptions(const std::string &text, const std::string &dictionary, const std::string& outputFileName,
-    const std::string &included, int mincard, int maxcard, int numThreads)
+    const std::vector<std::string> &included, int mincard, int maxcard, int numThreads)
     -> std::expected<void, std::string>
 {
     auto ret = setTargetText(text);
     if(!ret) {return std::unexpected(ret.error());}
 
-    ret = setIncludedText(included);
+    ret = setIncludedTexts(included);
     if(!ret) {return std::unexpected(ret.error());}
 
     ret = setRestrictions(mincard, maxcard);
@@ -64,30 +74,23 @@ void ArmaMagna::setDictionaryName(const std::string dictionary)
     this->dictionaryName = dictionary;
 }
 
-auto ArmaMagna::setIncludedText(const std::string included) -> std::expected<void, std::string>
+auto ArmaMagna::setIncludedTexts(const std::vector<std::string> &included) -> std::expected<void, std::string>
 {
-    this->includedText = included;
-
-    //Processes the included text
-    auto processedIncludedText = StringNormalizer::normalize(included);
-    if(!processedIncludedText) {return std::unexpected(processedIncludedText.error());}
-    includedTextSignature = WordSignature(processedIncludedText.value());
-
-    //Computes the number of included words
-    if(included == "") includedWordsNumber = 0;
-    else               includedWordsNumber = countWords(included);
-
-    //Invalid argument checking
-    if(!includedTextSignature.isSubsetOf(targetSignature)) {return std::unexpected("The included text must be a subset of the target text");}
-    if(targetSignature == includedTextSignature)           {return std::unexpected("The included is an anagram of the target text");}
+    this->includedTexts = included.empty() ? std::vector<std::string>{""} : included;
 
-    //actual = target - included
-    actualTargetSignature = targetSignature; 
-    actualTargetSignature -= includedTextSignature;
+    //Invalid argument checking, the alternatives themselves are built when the search starts
+    includedWordsNumber = 0;
+    for(const std::string &text : includedTexts)
+    {
+        auto processedIncludedText = StringNormalizer::normalize(text);
+        if(!processedIncludedText) {return std::unexpected(processedIncludedText.error());}
+        const WordSignature includedTextSignature(processedIncludedText.value());
 
-    //Computes the effective cardinalities
-    actualMinCardinality = minCardinality - includedWordsNumber;
-    actualMaxCardinality = maxCardinality - includedWordsNumber;
+        if(!includedTextSignature.isSubsetOf(targetSignature)) {return std::unexpected("The included text must be a subset of the target text");}
+        if(targetSignature == includedTextSignature)           {return std::unexpected("The included is an anagram of the target text");}
+        includedWordsNumber = std::max(includedWordsNumber, countWords(text));
+    }
+    taggedOutput = (includedTexts.size() > 1);
 
     return {};
 }
@@ -103,13 +106,147 @@ auto ArmaMagna::setRestrictions(int mincard, int maxcard) -> std::expected<void,
     this->minCardinality = mincard;
     this->maxCardinality = maxcard;
 
-    //Computes the actual cardinalities
-    actualMinCardinality = mincard - includedWordsNumber;
-    actualMaxCardinality = maxcard - includedWordsNumber;
+    return {};
+}
+
+//Every included text leaves its own target to the search. Alternatives leaving the same target share one query, searched
+//once over the union of their cardinalities. Invalid texts are an error, or are skipped if 'skipInvalid'
+auto ArmaMagna::buildAlternatives(const std::vector<std::string> &texts, bool skipInvalid) -> std::expected<void, std::string>
+{
+    alternatives.clear();
+    queries.clear();
+    for(const std::string &text : texts)
+    {
+        auto processedIncludedText = StringNormalizer::normalize(text);
+        if(!processedIncludedText) {return std::unexpected(processedIncludedText.error());}
+
+        Alternative alternative;
+        alternative.includedText = text;
+        alternative.includedSignature = WordSignature(processedIncludedText.value());
+        alternative.includedWordsNumber = text.empty() ? 0 : countWords(text);
+        alternative.minCardinality = std::max(minCardinality - alternative.includedWordsNumber, 1);
+        alternative.maxCardinality = maxCardinality - alternative.includedWordsNumber;
+
+        std::string invalid;
+        if(!alternative.includedSignature.isSubsetOf(targetSignature)) invalid = "The included text must be a subset of the target text";
+        else if(targetSignature == alternative.includedSignature)      invalid = "The included is an anagram of the target text";
+        else if(alternative.maxCardinality <= 0)                       invalid = "Maximum cardinality must be >= than the number of included words";
+        if(!invalid.empty())
+        {
+            if(!skipInvalid) {return std::unexpected(invalid);}
+            std::println("[*] Skipping '{}': {}", text, invalid);
+            continue;
+        }
+
+        //actual = target - included
+        WordSignature actualTargetSignature(targetSignature);
+        actualTargetSignature -= alternative.includedSignature;
+
+        auto query = std::ranges::find(queries, actualTargetSignature, &SearchQuery::target);
+        if(query == queries.end())
+        {
+            queries.push_back({WordSignature(actualTargetSignature), alternative.minCardinality, alternative.maxCardinality, {}, 0.0});
+            query = queries.end() - 1;
+        }
+        query->minCardinality = std::min(query->minCardinality, alternative.minCardinality);
+        query->maxCardinality = std::max(query->maxCardinality, alternative.maxCardinality);
+        query->alternatives.push_back(alternatives.size());
+        alternative.query = static_cast<size_t>(query - queries.begin());
+        alternatives.push_back(std::move(alternative));
+    }
+
+    return {};
+}
+
+auto ArmaMagna::setLengthBounds(int minLength, int maxLength) -> std::expected<void, std::string>
+{
+    if(minLength <= 0 || maxLength <= 0) {return std::unexpected("Word lengths must be positive");}
+    if(minLength > maxLength)            {return std::unexpected("Maximum word length must be greater or equal than minimum word length");}
+
+    this->minLength = minLength;
+    this->maxLength = std::min(maxLength, MAX_WORD_LENGTH);
+    return {};
+}
+
+void ArmaMagna::setExclusions(const std::string &excludeFileName, const std::vector<std::string> &anyOf)
+{
+    this->excludeFileName = excludeFileName;
+    this->anyOf = anyOf;
+}
+
+auto ArmaMagna::setWordFilters(const std::vector<std::string> &patterns) -> std::expected<void, std::string>
+{
+    std::vector<WordFilter> filters;
+    for(const std::string &pattern : patterns)
+    {
+        auto filter = WordFilter::compile(pattern);
+        if(!filter) {return std::unexpected(filter.error());}
+        filters.push_back(std::move(filter.value()));
+    }
+
+    dictionary.setWordFilters(filters);
+    this->wordFilterPatterns = patterns;
+    return {};
+}
+
+void ArmaMagna::setPinning(bool pinned)
+{
+    this->pinned = pinned;
+}
+
+void ArmaMagna::setSchedulePolicy(SchedulePolicy policy)
+{
+    this->schedulePolicy = policy;
+}
+
+void ArmaMagna::setSearchEngine(SearchEngine engine)
+{
+    this->searchEngine = engine;
+}
 
+void ArmaMagna::setExpandersNumber(unsigned int n)
+{
+    this->expandersNumber = (n > 0) ? n : 1;
+}
+
+auto ArmaMagna::setBudget(unsigned long long maxAnagrams, double timeoutSeconds) -> std::expected<void, std::string>
+{
+    if(timeoutSeconds < 0) {return std::unexpected("The timeout must be positive");}
+
+    this->maxAnagrams = maxAnagrams;
+    this->timeout = std::chrono::duration<double>(timeoutSeconds);
     return {};
 }
 
+void ArmaMagna::interrupt()
+{
+    interrupted.store(true);
+}
+
+auto ArmaMagna::setCheckpointing(double periodSeconds, bool resume) -> std::expected<void, std::string>
+{
+    if(periodSeconds < 0) {return std::unexpected("The checkpoint period must be positive");}
+
+    this->checkpointPeriod = (resume && periodSeconds == 0) ? DEFAULT_CHECKPOINT_PERIOD : periodSeconds;
+    this->resume = resume;
+    return {};
+}
+
+auto ArmaMagna::setShard(int index, int number) -> std::expected<void, std::string>
+{
+    if(number < 1 || index < 1 || index > number) {return std::unexpected("The shard must be K/N, with 1 <= K <= N");}
+
+    this->shardIndex = index;
+    this->shardsNumber = number;
+    return {};
+}
+
+void ArmaMagna::setRanking(size_t topNumber, const std::string &scoresFileName)
+{
+    this->topNumber = topNumber;
+    this->scoresFileName = scoresFileName;
+}
+
 void ArmaMagna::setThreadsNumber(unsigned int n)
 {
     if(n > std::thread::hardware_concurrency()) this->numThreads = std::thread::hardware_concurrency();
@@ -119,6 +256,9 @@ void ArmaMagna::setThreadsNumber(unsigned int n)
 
 auto ArmaMagna::anagram() -> std::expected<unsigned long long, std::string>
 {
+    auto built = buildAlternatives(includedTexts, false);
+    if(!built) {return std::unexpected(built.error());}
+
     //Output settings
     this->print();
 
@@ -126,123 +266,583 @@ auto ArmaMagna::anagram() -> std::expected<unsigned long long, std::string>
     auto wordsRead = dictionary.readWordList(dictionaryName, targetText);
     if(!wordsRead) {return std::unexpected(wordsRead.error());}
     std::print("[*] Read {} words from dictionary, ", wordsRead.value());
+    if(!excludeFileName.empty())
+    {
+        auto excluded = dictionary.excludeWordList(excludeFileName);
+        if(!excluded) {return std::unexpected(excluded.error());}
+        std::print("{} excluded", excluded.value());
+    }
+    dictionary.restrictLengthRange(minLength, maxLength); //Fewer lengths, fewer sets
     std::print(", after filter {}\n\n", dictionary.getActualWordsNumber());
 
+    //A ranked search outputs its anagrams at the end, there's nothing to cut or to resume along the way
+    if(topNumber > 0)
+    {
+        if(maxAnagrams > 0)     {return std::unexpected("--top and --limit can't be used together");}
+        if(checkpointPeriod > 0) {return std::unexpected("--top can't be checkpointed");}
+
+        auto scoresRead = wordScores.readScores(scoresFileName);
+        if(!scoresRead) {return std::unexpected(scoresRead.error());}
+        topAnagrams = std::make_unique<TopAnagrams>(topNumber);
+        std::println("[*] Read {} word scores, keeping the best {} anagrams\n", scoresRead.value(), topNumber);
+    }
+
+    if(!anyOf.empty() && checkpointPeriod > 0) {return std::unexpected("--any-of can't be checkpointed");}
+    if(searchEngine == SearchEngine::Letter && checkpointPeriod > 0) {return std::unexpected("--engine letter can't be checkpointed");}
+
+    //2 threads reserved for main and I/O, the others are shared by the search and the expansion stages
+    const int reservedThreads = 2 + static_cast<int>(expandersNumber);
+    int workersNumber = (static_cast<int>(numThreads) > reservedThreads) ? static_cast<int>(numThreads) - reservedThreads : 1;
+    int planWorkers = workersNumber; //Workers the tasks are cut for, the same for every shard of a sharded search
+    if(shardsNumber > 1) planWorkers = shardsNumber * SHARD_PLAN_WORKERS;
+
+    //A resumed search keeps the schedule of the first run, and the output it had written up to the checkpoint
+    if(checkpointPeriod > 0)
+    {
+        std::string included;
+        for(const std::string &text : includedTexts) included += text + "|";
+        std::string query = std::format("{}\t{}\t{}\t{}\t{}\t{}-{}\t{}\t{}\t{}/{}\t{}", targetText, dictionaryName, included, minCardinality, maxCardinality,
+                                        minLength, maxLength, (schedulePolicy == SchedulePolicy::Throughput) ? "throughput" : "first-results",
+                                        (searchEngine == SearchEngine::Iterative) ? "iterative" : "recursive", //The letter engine isn't checkpointed
+                                        shardIndex, shardsNumber, excludeFileName);
+        for(const std::string &pattern : wordFilterPatterns) query += "\t" + pattern;
+        checkpoint = std::make_unique<Checkpoint>(outputFileName + ".checkpoint", query, planWorkers);
+    }
+    if(resume)
+    {
+        auto loaded = checkpoint->load();
+        if(!loaded) {return std::unexpected(loaded.error());}
+        planWorkers = checkpoint->getPlanWorkers();
+
+        std::error_code error;
+        if(std::filesystem::file_size(outputFileName, error) < checkpoint->getOutputOffset() || error) {return std::unexpected("The output file is shorter than its checkpoint");}
+        std::filesystem::resize_file(outputFileName, checkpoint->getOutputOffset(), error); //Partial output is dropped
+        if(error) {return std::unexpected("Cannot truncate output file: " + error.message());}
+
+        this->outputOffset = checkpoint->getOutputOffset();
+        this->anagramCount = checkpoint->getAnagramsNumber();
+        std::println("[*] Resuming from {}.checkpoint, {} anagrams already found\n", outputFileName, this->anagramCount);
+    }
+
     //Opens the output file
-    this->ofstream.open(this->outputFileName, std::ios::out);
+    this->ofstream.open(this->outputFileName, resume ? std::ios::app : std::ios::out);
     if(!this->ofstream.is_open()) {return std::unexpected("Cannot open output file");}
 
     auto startTime = std::chrono::steady_clock::now();
-    {   //I/O thread RAII scope
+    if(anyOf.empty())
+    {
+        auto searched = search(workersNumber, planWorkers, startTime);
+        if(!searched) {return std::unexpected(searched.error());}
+    }
+    else
+    {
+        //One search per word, each including it. Every word is dropped from the dictionary once its search is over,
+        //so that the later searches can't find the anagrams it already produced
+        for(const std::string &word : anyOf)
+        {
+            if(stopReason.load() != StopReason::None) break;
+
+            std::vector<std::string> texts;
+            for(const std::string &text : includedTexts) texts.push_back(text.empty() ? word : text + " " + word);
+            auto built = buildAlternatives(texts, true);
+            if(!built) {return std::unexpected(built.error());}
+
+            if(!alternatives.empty())
+            {
+                std::println("[*] Searching the anagrams including '{}'", word);
+                auto searched = search(workersNumber, planWorkers, startTime);
+                if(!searched) {return std::unexpected(searched.error());}
+            }
+            dictionary.excludeWords({word});
+        }
+    }
+
+    if(topAnagrams != nullptr) writeTopAnagrams(); //The expanders are done, the ranking is final
+    std::println("[*] Found {} anagrams, output in {}", this->anagramCount, this->outputFileName);
+
+    auto endTime = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = endTime - startTime;
+    std::println("[*] Search time: {:.2f} s", elapsed.count()/1000);
+    switch(stopReason.load())
+    {
+        case StopReason::Limit:     std::println("[*] Search stopped: {} anagrams found", this->maxAnagrams); break;
+        case StopReason::Timeout:   std::println("[*] Search stopped: time budget exhausted"); break;
+        case StopReason::Interrupt: std::println("[*] Search stopped: interrupted"); break;
+        case StopReason::None:      break;
+    }
+
+    this->ofstream.close();
+    return this->anagramCount;
+}
+
+//Searches the anagrams of the current included text, with the loaded dictionary. The I/O thread lives as long as the search
+auto ArmaMagna::search(int workersNumber, int planWorkers, std::chrono::steady_clock::time_point startTime) -> std::expected<void, std::string>
+{
+    //Every search starts from scratch, only the dictionary and the output are shared
+    searchIsComplete.store(false);
+    this->totalCost = 0.0;
+    this->exploredCost = 0.0;
+    this->exploredSetsNumber = 0;
+    transpositionTable.clear(); //The subproblems depend on the dictionary, which may have changed
+    if(topAnagrams != nullptr)
+    {
+        for(Alternative &alternative : alternatives)
+        {
+            alternative.includedScore = 0.0;
+            for(const auto word : alternative.includedText | std::views::split(' '))
+            {
+                if(!word.empty()) alternative.includedScore += wordScores.getScore(std::string(word.begin(), word.end()));
+            }
+        }
+        for(SearchQuery &query : queries)
+        {
+            query.bestIncludedScore = -std::numeric_limits<double>::infinity();
+            for(const size_t a : query.alternatives) query.bestIncludedScore = std::max(query.bestIncludedScore, alternatives[a].includedScore);
+        }
+    }
+
+    {   //Thread pool RAII scope
+
+        //Every query has its own planner. Lengths whose section has no signature fitting the query's target are useless
+        //Computes the power set from the word lengths that are available in the dictionary after filtering,
+        //discards the infeasible sets, orders the levels of every other set and estimates its cost
+        std::vector<SetPlanner> planners;
+        planners.reserve(queries.size());
+        std::vector<PlannedSet> plannedSets;
+        std::vector<size_t> firstSets;  //Index of the first planned set of every query, they are stored query by query
+        size_t infeasibleSetsNumber = 0;
+        std::vector<LetterIndex> letterIndexes; //The letter engine has no length sets, every query is a single set
+        letterIndexes.reserve(queries.size());
+        for(const auto [q, query] : queries | std::views::enumerate)
+        {
+            firstSets.push_back(plannedSets.size());
+            if(searchEngine == SearchEngine::Letter)
+            {
+                //Estimated cost: the subtrees of the first letter's entries
+                const LetterIndex &index = letterIndexes.emplace_back(dictionary, query.target, static_cast<size_t>(q));
+                const double cost = index.getLetters().empty() ? 0.0 : static_cast<double>(index.getList(index.getLetters().front()).size());
+                plannedSets.push_back({0, {}, cost, static_cast<size_t>(q)});
+                this->totalCost += cost;
+                continue;
+            }
+            SetPlanner &planner = planners.emplace_back(dictionary, query.target);
+
+            std::vector<int> availableLengths;
+            for(const int length : dictionary.getAvailableLengths())
+            {
+                if(planner.getStats(length).filteredSize > 0) availableLengths.push_back(length);
+            }
+            if(availableLengths.empty()) continue;
+
+            RepeatedCombinationsWithSum rcs(query.target.getCharactersNumber(), query.minCardinality, query.maxCardinality, availableLengths);
+            for(size_t i=0; i<rcs.getSetsNumber(); i++)
+            {
+                const std::vector<int> &set = rcs.getSet(i);
+                if(!planner.isFeasible(set)) {infeasibleSetsNumber++; continue;}
+
+                std::vector<int> orderedSet = planner.orderLevels(set);
+                const double cost = planner.estimateCost(orderedSet);
+                plannedSets.push_back({i, std::move(orderedSet), cost, static_cast<size_t>(q)});
+                this->totalCost += plannedSets.back().cost;
+            }
+        }
+        firstSets.push_back(plannedSets.size());
+        this->setsNumber = plannedSets.size();
+
+        std::vector<int> usedLengths;
+        for(const PlannedSet &plannedSet : plannedSets)
+        {
+            for(const int length : plannedSet.wordLengths)
+            {
+                if(!std::ranges::contains(usedLengths, length)) usedLengths.push_back(length);
+            }
+        }
+        //Sections that no feasible set uses are dropped from the dictionary, unless other searches follow
+        if(anyOf.empty() && searchEngine != SearchEngine::Letter) dictionary.restrictLengths(usedLengths);
+        if(topAnagrams != nullptr) wordScores.indexDictionary(dictionary);
+
+        //A single pair-sum table serves every query: it stores the sums that fit any of their targets
+        WordSignature pairBound;
+        for(const SearchQuery &query : queries)
+        {
+            for(size_t c=0; c<pairBound.table.size(); c++) pairBound.table[c] = std::max(pairBound.table[c], query.target.table[c]);
+        }
+        replicateDictionary();
+        pairSumTables.clear();
+        pairTablesMemory.store(0); //The copies on every node share one memory cap
+        for(size_t node=0; node<std::max<size_t>(replicas.size(), 1); node++)
+        {
+            pairSumTables.push_back(std::make_unique<PairSumTables>(nodeDictionary(node), pairBound, pairTablesMemory));
+        }
+
+        solutionPipeline = std::make_unique<SolutionPipeline>(*this, static_cast<int>(expandersNumber));
+        WorkStealingPool pool(workersNumber);
+
+        //Orders (and possibly slices) the sets according to the schedule policy, the tasks of all the queries together
+        std::vector<SearchTask> tasks;
+        for(size_t q=0; q<queries.size() && searchEngine == SearchEngine::Letter; q++)
+        {
+            const size_t set = firstSets[q];
+            for(const SearchTask &task : letterIndexes[q].schedule(set, plannedSets[set].cost, planWorkers, schedulePolicy)) tasks.push_back(task);
+        }
+        for(size_t q=0; q<queries.size() && searchEngine != SearchEngine::Letter; q++)
+        {
+            const std::vector<PlannedSet> querySets(plannedSets.begin() + static_cast<std::ptrdiff_t>(firstSets[q]),
+                                                    plannedSets.begin() + static_cast<std::ptrdiff_t>(firstSets[q + 1]));
+            for(SearchTask task : planners[q].schedule(querySets, schedulePolicy, planWorkers, this->totalCost))
+            {
+                task.set += firstSets[q];
+                tasks.push_back(task);
+            }
+        }
+        if(queries.size() > 1 || searchEngine == SearchEngine::Letter) SetPlanner::order(tasks, schedulePolicy);
+
+        //Snapshot of what the previous run wrote of every task, the checkpoint keeps changing during the search
+        std::vector<TaskProgress> resumedTasks;
+        if(checkpoint != nullptr)
+        {
+            std::vector<size_t> firstBegins;
+            for(const SearchTask &task : tasks) firstBegins.push_back(task.firstBegin);
+            auto attached = checkpoint->attachTasks(firstBegins);
+            if(!attached) {return std::unexpected(attached.error());}
+            if(resume) for(const SearchTask &task : tasks) resumedTasks.push_back(checkpoint->getProgress(task.id));
+        }
+
+        std::println("[*] Starting {} search threads, {} expansion threads", workersNumber, expandersNumber);
+        if(searchEngine == SearchEngine::Letter)
+        {
+            std::string firstLetters;
+            for(const LetterIndex &index : letterIndexes)
+            {
+                if(!index.getLetters().empty()) firstLetters += std::format("{} ", static_cast<char>('a' + index.getLetters().front()));
+            }
+            if(!firstLetters.empty()) firstLetters.pop_back();
+            std::println("[*] Letter engine, every length at once, first letter: {}", firstLetters);
+        }
+        else
+        {
+            std::println("[*] Covering {} length combinations ({} infeasible discarded)", this->setsNumber, infeasibleSetsNumber);
+        }
+        if(!plannedSets.empty() && searchEngine != SearchEngine::Letter)
+        {
+            const PlannedSet &heaviest = *std::ranges::max_element(plannedSets, {}, &PlannedSet::cost);
+            std::string heaviestLengths;
+            for(const int length : heaviest.wordLengths) heaviestLengths += std::format("{} ", length);
+            heaviestLengths.pop_back();
+            std::println("[*] Estimated search cost: {:.3g} nodes, heaviest set [{}] ({:.1f}%)", this->totalCost, heaviestLengths,
+                         (this->totalCost > 0) ? 100.0 * heaviest.cost / this->totalCost : 0.0);
+        }
+
+        //A shard only searches, and only accounts for, its own share of the tasks
+        if(shardsNumber > 1)
+        {
+            const size_t allTasksNumber = tasks.size();
+            const double allCost = this->totalCost;
+            tasks = SetPlanner::shard(tasks, shardIndex, shardsNumber);
+
+            this->totalCost = 0.0;
+            for(const SearchTask &task : tasks) this->totalCost += task.cost;
+            std::println("[*] Shard {}/{}: {} of {} tasks, {:.1f}% of the estimated work", shardIndex, shardsNumber, tasks.size(), allTasksNumber,
+                         (allCost > 0) ? 100.0 * this->totalCost / allCost : 0.0);
+        }
+        std::println("[*] Posting {} tasks, schedule: {}\n", tasks.size(),
+                     (schedulePolicy == SchedulePolicy::Throughput) ? "throughput" : "first results");
+
+        //Number of unfinished slices of every set, the set is explored when its last slice ends
+        //The tasks a previous run completed count as explored right away
+        std::vector<std::atomic<size_t>> pendingSlices(plannedSets.size());
+        std::vector<bool> searchedSets(plannedSets.size(), false);
+        for(const SearchTask &task : tasks)
+        {
+            searchedSets[task.set] = true;
+            if(resume && resumedTasks[task.id].done) this->exploredCost += task.cost;
+            else                                     pendingSlices[task.set]++;
+        }
+        this->setsNumber = static_cast<size_t>(std::ranges::count(searchedSets, true));
+        for(size_t set=0; set<plannedSets.size(); set++)
+        {
+            if(searchedSets[set] && pendingSlices[set] == 0) this->exploredSetsNumber++;
+        }
+
         ioThread = std::jthread(&ArmaMagna::ioLoop, this);
+        std::jthread watchdog([this, startTime](std::stop_token token) {watchdogLoop(token, startTime);});
 
-        //Computes the power set from the word lengths that are available in the dictionary after filtering
-        std::vector<int> availableLengths = dictionary.getAvailableLengths();
-        RepeatedCombinationsWithSum rcs(actualTargetSignature.getCharactersNumber(), actualMinCardinality, actualMaxCardinality, availableLengths);
-        this->setsNumber = rcs.getSetsNumber();
-        
-        int workersNumber = (numThreads > 2) ? numThreads - 2 : 1;  //2 threads reserved for main and I/O
-        boost::asio::thread_pool pool(workersNumber);
+        //Runs a task, or a piece that a running task gave away to an idle worker, which is one more slice of its set
+        std::function<void(const SearchTask&, const TaskProgress*)> runTask = [this, &plannedSets, &letterIndexes, &pendingSlices](const SearchTask &task, const TaskProgress* resumed)
+        {
+            if(stopSource.stop_requested()) return; //Queued tasks are drained without searching
+            if(pinned) pinWorker();
 
-        std::println("[*] Starting {} search threads", workersNumber);
-        std::println("[*] Covering {} length combinations\n", this->setsNumber);
+            double searchedCost = 0.0;
+            if(searchEngine == SearchEngine::Letter)
+            {
+                LetterSearch letterSearch(*this, letterIndexes[plannedSets[task.set].query], task);
+                letterSearch();
+                if(letterSearch.wasStopped()) return;
+                searchedCost = letterSearch.getCost();
+            }
+            else
+            {
+                SearchThread searchThread(*this, plannedSets[task.set], task, resumed);
+                searchThread();
+                if(searchThread.wasStopped()) return;
+                if(checkpoint != nullptr) checkpoint->onTaskFinished(task.id, searchThread.getBatchesNumber());
+                searchedCost = searchThread.getCost();
+            }
+            this->exploredCost += searchedCost;                               //☢️
+            if(--pendingSlices[task.set] == 0) this->exploredSetsNumber++; //☢️
+            this->anagramRing.wake(); //The progress line may need a refresh
+        };
+        workerPool = &pool;
+        spawnTask = [&pool, &pendingSlices, &runTask](const SearchTask &piece)
+        {
+            pendingSlices[piece.set]++; //☢️ Before its parent ends, so that the set can't be counted as explored early
+            pool.spawn([&runTask, piece] {runTask(piece, nullptr);});
+        };
 
         //Search - Producer section
-        for(size_t i=0; i<this->setsNumber; i++)
+        for(const SearchTask &task : tasks)
         {
-            std::vector<int> set = rcs.getSet(i);
-            
-            boost::asio::post(pool, [this, set]
-                {
-                    SearchThread searchThread(*this, set);
-                    searchThread();
-                    this->exploredSetsNumber++; //☢️
-                }
-            );
+            const TaskProgress* resumed = resume ? &resumedTasks[task.id] : nullptr;
+            if(resumed != nullptr && resumed->done) continue;
+
+            pool.post([&runTask, task, resumed] {runTask(task, resumed);});
         }
 
         pool.join();
-    }   //I/O thread destroyed here
-
-    //Signals the I/O thread that the search is complete
+        spawnTask = nullptr;
+        workerPool = nullptr;
+        solutionPipeline->close(); //The expanders drain the signature solutions left
+        pairSumTables.clear();
+        replicas.clear();
+    }   //Thread pool destroyed here
+
+    //Signals the I/O thread that the search is complete, and waits for it to drain the queue before closing the file
     searchIsComplete.store(true);
-    anagramQueueCV.notify_one();
+    anagramRing.wake();
+    ioThread.join();
 
-    auto endTime = std::chrono::steady_clock::now();
-    std::chrono::duration<double, std::milli> elapsed = endTime - startTime;
-    std::println("[*] Search time: {:.2f} s", elapsed.count()/1000);
+    return {};
+}
 
-    this->ofstream.close();
-    return this->anagramCount;
+//The workers take the cores in turn, one node after the other, so that a few workers already spread over all the nodes
+void ArmaMagna::pinWorker()
+{
+    thread_local bool isPinned = false; //Pool threads live as long as the search
+    if(isPinned || workerCpus.empty()) return;
+
+    isPinned = true;
+    Topology::pinCurrentThread(workerCpus[pinnedWorkers++ % workerCpus.size()]);
+}
+
+//Every node gets a copy made by a thread running on it, so that its memory is allocated there. The entries keep
+//their indices in every copy, so the pair-sum tables, the memo, the scores and the checkpoints don't depend on it
+void ArmaMagna::replicateDictionary()
+{
+    replicas.clear();
+    workerCpus.clear();
+    pinnedWorkers = 0;
+    if(!pinned) return;
+
+    std::vector<int> cpus = Topology::allowedCpus();
+    std::vector<size_t> rank(cpus.size()); //Position of every cpu among the ones of its node
+    std::vector<size_t> nodeCpus(static_cast<size_t>(Topology::nodesNumber()), 0);
+    for(size_t i=0; i<cpus.size(); i++)
+    {
+        const size_t node = std::min(static_cast<size_t>(Topology::nodeOfCpu(cpus[i])), nodeCpus.size() - 1);
+        rank[i] = nodeCpus[node]++;
+    }
+    std::vector<size_t> order(cpus.size());
+    for(size_t i=0; i<order.size(); i++) order[i] = i;
+    std::ranges::stable_sort(order, {}, [&rank](size_t i) {return rank[i];});
+    for(const size_t i : order) workerCpus.push_back(cpus[i]);
+
+    const size_t nodes = static_cast<size_t>(std::ranges::count_if(nodeCpus, [](size_t n) {return n > 0;}));
+    if(nodes <= 1)
+    {
+        std::println("[*] Pinning the workers to {} cores", workerCpus.size());
+        return;
+    }
+
+    replicas.resize(nodeCpus.size());
+    {
+        std::vector<std::jthread> copiers;
+        for(size_t node=0; node<replicas.size(); node++)
+        {
+            if(nodeCpus[node] == 0) continue; //No worker runs there, it keeps using the original
+            copiers.emplace_back([this, node]
+                {
+                    Topology::runOnNode(static_cast<int>(node));
+                    replicas[node] = std::make_unique<Dictionarium>(dictionary);
+                }
+            );
+        }
+    }   //Joined here
+    std::println("[*] Pinning the workers to {} cores, dictionary replicated on {} NUMA nodes", workerCpus.size(), nodes);
+}
+
+size_t ArmaMagna::localNode() const
+{
+    if(replicas.empty()) return 0;
+    return std::min(static_cast<size_t>(Topology::currentNode()), replicas.size() - 1);
+}
+
+//Time the I/O thread must wake up at, for the progress line or the checkpoint, whichever comes first
+auto ArmaMagna::nextDeadline(std::chrono::steady_clock::time_point lastDisplayTime,
+                             std::chrono::steady_clock::time_point lastCheckpointTime) const -> std::chrono::steady_clock::time_point
+{
+    const auto displayDeadline = lastDisplayTime + PROGRESS_PERIOD;
+    if(checkpoint == nullptr) return displayDeadline;
+    return std::min(displayDeadline, lastCheckpointTime + checkpointInterval());
 }
 
 void ArmaMagna::ioLoop()
 {
     auto lastDisplayTime =  std::chrono::steady_clock::now();
+    auto lastCheckpointTime = lastDisplayTime;
+    uint64_t checkpointOffset = this->outputOffset;               //Output offset after the last whole batch
+    unsigned long long checkpointAnagrams = this->anagramCount;   //Anagrams up to that offset
+    ioDeadline.store(nextDeadline(lastDisplayTime, lastCheckpointTime));
 
-    bool shouldTerminate = false;
     std::string currentAnagram;
     while(true)
     {
-        /*******************CONSUMER CRITICAL SECTION*******************/
+        //Every batch is published before the search is marked complete, so the ring is drained once the flag is read
+        const bool searchDone = searchIsComplete.load();
+        std::unique_ptr<AnagramBatch> batch = anagramRing.pop();
+
+        /*******************I/O PROCESSING*******************/
+        if(batch) //If there's something, output to file
         {
-            std::unique_lock<std::mutex> lock(anagramQueueMutex); //unique_lock is needed because of CV.wait()
-            
-            //Wait for data to arrive or the termination signal
-            auto exitFunction = [this] {return !anagramQueue.empty() || searchIsComplete.load();};
-            anagramQueueCV.wait_for(lock, std::chrono::milliseconds(1000), exitFunction);
-
-            if(searchIsComplete.load() && anagramQueue.empty()) shouldTerminate = true; //Can't call "break" here because of lock RAII
-            else if(!anagramQueue.empty())
+            //Past the limit, the batches still coming are drained but not written
+            size_t writable = batch->size();
+            if(maxAnagrams > 0) writable = static_cast<size_t>(std::min<unsigned long long>(writable, maxAnagrams - anagramCount));
+
+            size_t offset = 0;
+            std::string_view entry;
+            for(size_t i=0; i<writable; i++)
             {
-                this->anagramCount++;
-                currentAnagram = anagramQueue.front();
-                anagramQueue.pop();
+                entry = batch->next(offset);
+                this->ofstream << entry << '\n';
+                this->outputOffset += entry.size() + 1;
             }
-        } //Lock released
+            this->ofstream.flush();
+            if(writable > 0) currentAnagram = entry;
 
-        if(shouldTerminate) break;
+            this->anagramCount += writable;
+            if(maxAnagrams > 0 && anagramCount == maxAnagrams) requestStop(StopReason::Limit);
 
-        /*******************I/O PROCESSING*******************/
-        if(!currentAnagram.empty()) //If there's something, output to file
-        {
-            this->ofstream << currentAnagram << std::endl;
-            this->ofstream.flush();
+            //Only whole batches count for the checkpoint, a resume truncates the output after the last one
+            if(checkpoint != nullptr && writable == batch->size())
+            {
+                for(const BatchTag &tag : batch->tags) checkpoint->onWritten(tag);
+                checkpointOffset = this->outputOffset;
+                checkpointAnagrams = this->anagramCount;
+            }
         }
+        else if(searchDone) break;
+        else anagramRing.waitForBatch(searchIsComplete); //Spins, then parks until a batch or a wake up comes
 
-        //Update console every 1 second
+        //Update console every 1 second, and the checkpoint every few seconds
         auto now = std::chrono::steady_clock::now();
-        if(now - lastDisplayTime >= std::chrono::milliseconds(1000))
+        if(checkpoint != nullptr && now - lastCheckpointTime >= checkpointInterval())
+        {
+            saveCheckpoint(checkpointOffset, checkpointAnagrams);
+            lastCheckpointTime = now;
+        }
+        if(now - lastDisplayTime >= PROGRESS_PERIOD)
         {
-            std::print("\r[{}/{} sets] {}: {}{}", this->exploredSetsNumber.load(), this->setsNumber, this->anagramCount, currentAnagram, std::string(30, ' '));
+            printProgress(currentAnagram);
             std::cout << std::flush;
             lastDisplayTime = now;
         }
+
+        //A task can end without output, the watchdog wakes the loop up when the progress line or the checkpoint is due anyway
+        ioDeadline.store(nextDeadline(lastDisplayTime, lastCheckpointTime));
     }
 
-    std::print("\r[{}/{} sets] {}: {}{}", this->exploredSetsNumber.load(), this->setsNumber, this->anagramCount, currentAnagram, std::string(30, ' '));
-    std::println("\n\n[*] Found {} anagrams, output in {}", this->anagramCount, this->outputFileName);
+    if(checkpoint != nullptr) saveCheckpoint(checkpointOffset, checkpointAnagrams);
+    printProgress(currentAnagram);
+    std::println("\n");
     std::cout << std::flush;
     return;
 }
 
+void ArmaMagna::saveCheckpoint(uint64_t offset, unsigned long long anagrams)
+{
+    auto saved = checkpoint->save(offset, anagrams);
+    if(!saved) std::println("\n[!] {}", saved.error());
+}
+
+//One anagram per line, best first, followed by its score
+void ArmaMagna::writeTopAnagrams()
+{
+    for(const ScoredAnagram &anagram : topAnagrams->getSorted())
+    {
+        this->ofstream << std::format("{}\t{}\n", anagram.text, anagram.score);
+        this->anagramCount++;
+    }
+    this->ofstream.flush();
+}
+
+//Polls the SIGINT flag and the time budget, until the search ends. The signal handler can't touch the stop source
+//itself, since requesting a stop isn't async-signal-safe
+void ArmaMagna::watchdogLoop(std::stop_token token, std::chrono::steady_clock::time_point startTime)
+{
+    std::mutex mutex;
+    std::condition_variable_any cv;
+    std::unique_lock lock(mutex);
+
+    while(!token.stop_requested())
+    {
+        cv.wait_for(lock, token, WATCHDOG_PERIOD, [] {return false;}); //Sleeps, woken up early at the end of the search
+
+        const auto now = std::chrono::steady_clock::now();
+        if(interrupted.load()) {requestStop(StopReason::Interrupt); return;}
+        if(timeout.count() > 0 && now - startTime >= timeout) {requestStop(StopReason::Timeout); return;}
+        if(now >= ioDeadline.load()) anagramRing.wake(); //The I/O thread may be parked past its deadline
+    }
+}
+
+//Only the first reason is kept
+void ArmaMagna::requestStop(StopReason reason)
+{
+    StopReason expected = StopReason::None;
+    stopReason.compare_exchange_strong(expected, reason);
+    stopSource.request_stop();
+}
+
+//Progress line, the estimated work share tells how far the search really is, since sets differ wildly in cost
+void ArmaMagna::printProgress(const std::string &currentAnagram)
+{
+    const double workDone = (this->totalCost > 0) ? 100.0 * this->exploredCost.load() / this->totalCost : 100.0;
+    std::print("\r[{}/{} sets, {:.1f}% est. work] {}: {}{}", this->exploredSetsNumber.load(), this->setsNumber, workDone,
+               this->anagramCount, currentAnagram, std::string(30, ' '));
+}
+
 void ArmaMagna::print()
 {
     std::println("\nArmaMagna multi-threaded anagrammer engine\n");
 
     std::println("{:<40}{}", "[*] Target text:",               targetText);
     std::println("{:<40}{}", "[*] Dictionary:",                dictionaryName);
-    std::println("{:<40}{}", "[*] Included text:",             includedText.empty() ? "<void>" : includedText);
+    for(const std::string &text : includedTexts) std::println("{:<40}{}", "[*] Included text:", text.empty() ? "<void>" : text);
     std::println("{:<40}({},{})", "[*] Cardinality:",          minCardinality, maxCardinality);
+    std::println("{:<40}({},{})", "[*] Word length:",          minLength, maxLength);
+    for(const std::string &pattern : wordFilterPatterns) std::println("{:<40}{}", "[*] Word filter:", pattern);
     std::println("{:<40}{}", "[*] Estimated concurrency:",     std::thread::hardware_concurrency());
     std::println("{:<40}{}", "[*] Threads to launch:",         numThreads);
     std::println("");
 
     std::println("{:<40}{}", "[*] Target signature:",           targetSignature.toString());
-    std::println("{:<40}{}", "[*] Included words number:",      includedWordsNumber);
-    std::println("{:<40}{}", "[*] Included text signature:",    includedText.empty() ? "<void>" : std::format("{}", includedTextSignature.toString()));
-    std::println("{:<40}{}", "[*] Actual target signature:",    actualTargetSignature.toString());
-    std::println("{:<40}({},{})", "[*] Actual cardinality:",    actualMinCardinality, actualMaxCardinality);
+    for(const Alternative &alternative : alternatives)
+    {
+        std::println("{:<40}{}", "[*] Included words number:",      alternative.includedWordsNumber);
+        std::println("{:<40}{}", "[*] Included text signature:",    alternative.includedText.empty() ? "<void>" : std::format("{}", alternative.includedSignature.toString()));
+        std::println("{:<40}{}", "[*] Actual target signature:",    queries[alternative.query].target.toString());
+        std::println("{:<40}({},{})", "[*] Actual cardinality:",    alternative.minCardinality, alternative.maxCardinality);
+    }
+    if(alternatives.size() > queries.size()) std::println("{:<40}{}", "[*] Distinct actual targets:", queries.size());
     std::println("");
 }
 
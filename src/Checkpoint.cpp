@@ -0,0 +1,159 @@
+#include <filesystem>  //For std::filesystem::rename
+#include <expected>   //For std::expected, std::unexpected
+#include <fstream>    //For std::ifstream, std::ofstream
+#include <sstream>   //For std::istringstream
+#include <cstdint>  //For uint64_t, int64_t, SIZE_MAX
+#include <string>   //For std::string, std::getline
+#include <vector>   //For std::vector
+
+#include "Checkpoint.h"
+
+//File layout, one record per line:
+//  armamagna-checkpoint
+//  query <options>
+//  workers <plan workers>
+//  output <offset> <anagrams>
+//  tasks <number of tasks>
+//  done <task>
+//  partial <task> <cursor> <entry base> <watermark> <ahead> [<seq> <entry> <entry base> <last of entry>]...
+Checkpoint::Checkpoint(const std::string &fileName, const std::string &query, int planWorkers)
+    : fileName(fileName), query(query), planWorkers(planWorkers)
+{
+    //Empty
+}
+
+auto Checkpoint::load() -> std::expected<void, std::string>
+{
+    std::ifstream file(fileName, std::ios::in);
+    if(!file) {return std::unexpected("Cannot open checkpoint " + fileName);}
+
+    std::string line, keyword;
+    if(!std::getline(file, line) || line != "armamagna-checkpoint") {return std::unexpected("Not a checkpoint: " + fileName);}
+    if(!std::getline(file, line) || line != "query " + query)      {return std::unexpected("The checkpoint belongs to a different query");}
+
+    while(std::getline(file, line))
+    {
+        std::istringstream record(line);
+        record >> keyword;
+
+        if(keyword == "workers")     record >> planWorkers;
+        else if(keyword == "output") record >> outputOffset >> anagramsNumber;
+        else if(keyword == "tasks")  {size_t tasksNumber = 0; record >> tasksNumber; progress.resize(tasksNumber);}
+        else if(keyword == "done" || keyword == "partial")
+        {
+            size_t task = 0;
+            record >> task;
+            if(task >= progress.size()) {return std::unexpected("Corrupted checkpoint, task out of range");}
+
+            TaskProgress &p = progress[task];
+            p.done = (keyword == "done");
+            if(!p.done)
+            {
+                size_t aheadNumber = 0;
+                record >> p.cursor >> p.entryBase >> p.watermark >> aheadNumber;
+                for(size_t i=0; i<aheadNumber; i++)
+                {
+                    BatchTag tag;
+                    tag.task = task;
+                    record >> tag.seq >> tag.entry >> tag.entryBase >> tag.lastOfEntry;
+                    p.ahead.emplace(tag.seq, tag);
+                }
+            }
+        }
+        else {return std::unexpected("Corrupted checkpoint, unknown record " + keyword);}
+
+        if(record.fail()) {return std::unexpected("Corrupted checkpoint, bad record " + keyword);}
+    }
+
+    return {};
+}
+
+//The schedule is rebuilt from the stored plan workers, any other task count means a different plan
+auto Checkpoint::attachTasks(const std::vector<size_t> &firstBegins) -> std::expected<void, std::string>
+{
+    if(progress.empty()) progress.resize(firstBegins.size());
+    if(progress.size() != firstBegins.size()) {return std::unexpected("The checkpoint belongs to a different schedule");}
+
+    finishedBatches = std::vector<std::atomic<int64_t>>(firstBegins.size());
+    for(size_t task=0; task<firstBegins.size(); task++)
+    {
+        if(progress[task].cursor == SIZE_MAX) progress[task].cursor = firstBegins[task]; //Not started yet
+        finishedBatches[task].store(-1);
+    }
+    return {};
+}
+
+auto Checkpoint::save(uint64_t offset, unsigned long long anagrams) -> std::expected<void, std::string>
+{
+    this->outputOffset = offset;
+    this->anagramsNumber = anagrams;
+
+    const std::string temporaryName = fileName + ".tmp";
+    {
+        std::ofstream file(temporaryName, std::ios::out | std::ios::trunc);
+        if(!file) {return std::unexpected("Cannot write checkpoint " + temporaryName);}
+
+        file << "armamagna-checkpoint\n" << "query " << query << '\n' << "workers " << planWorkers << '\n';
+        file << "output " << outputOffset << ' ' << anagramsNumber << '\n' << "tasks " << progress.size() << '\n';
+        for(size_t task=0; task<progress.size(); task++)
+        {
+            TaskProgress &p = progress[task];
+            const int64_t finished = finishedBatches[task].load();
+            if(!p.done && finished >= 0 && p.watermark >= static_cast<uint64_t>(finished)) p.done = true;
+
+            if(p.done) {file << "done " << task << '\n'; continue;}
+            if(p.watermark == 0 && p.ahead.empty()) continue; //Untouched
+
+            file << "partial " << task << ' ' << p.cursor << ' ' << p.entryBase << ' ' << p.watermark << ' ' << p.ahead.size();
+            for(const auto &[seq, tag] : p.ahead) file << ' ' << seq << ' ' << tag.entry << ' ' << tag.entryBase << ' ' << tag.lastOfEntry;
+            file << '\n';
+        }
+        if(!file.flush()) {return std::unexpected("Cannot write checkpoint " + temporaryName);}
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryName, fileName, error);
+    if(error) {return std::unexpected("Cannot write checkpoint " + fileName + ": " + error.message());}
+    return {};
+}
+
+//Moves the watermark over the consecutive written batches. The restart point follows it: after the last batch of an
+//entry, the search restarts from the next entry, otherwise from the first batch of the entry
+void Checkpoint::onWritten(const BatchTag &tag)
+{
+    TaskProgress &p = progress[tag.task];
+    p.ahead.emplace(tag.seq, tag);
+
+    for(auto it = p.ahead.begin(); it != p.ahead.end() && it->first == p.watermark; it = p.ahead.erase(it))
+    {
+        const BatchTag &written = it->second;
+        p.cursor = written.lastOfEntry ? written.entry + 1 : written.entry;
+        p.entryBase = written.lastOfEntry ? written.seq + 1 : written.entryBase;
+        p.watermark++;
+    }
+}
+
+void Checkpoint::onTaskFinished(size_t task, uint64_t batchesNumber)
+{
+    finishedBatches[task].store(static_cast<int64_t>(batchesNumber));
+}
+
+const TaskProgress& Checkpoint::getProgress(size_t task) const
+{
+    return progress[task];
+}
+
+uint64_t Checkpoint::getOutputOffset() const
+{
+    return outputOffset;
+}
+
+unsigned long long Checkpoint::getAnagramsNumber() const
+{
+    return anagramsNumber;
+}
+
+int Checkpoint::getPlanWorkers() const
+{
+    return planWorkers;
+}
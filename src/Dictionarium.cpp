@@ -1,7 +1,8 @@
+#include <algorithm>     //For std::ranges::contains, std::ranges::all_of
 #include <expected>      //For std::expected, std::unexpected
 #include <fstream>      //For std::ifstream
 #include <cassert>     //For assert
-#include <string>     //For std::string
+#include <string>     //For std::string, std::erase_if
 #include <ranges>    //For std::views
 #include <set>      //For std::set
 
@@ -16,6 +17,11 @@ Dictionarium::Dictionarium()
     //Empty
 }
 
+void Dictionarium::setWordFilters(const std::vector<WordFilter> &filters)
+{
+    this->wordFilters = filters;
+}
+
 auto Dictionarium::readWordList(const std::string& dictionaryName, const std::string& sourceText) -> std::expected<int, std::string>
 {
     //Opens the file
@@ -46,14 +52,18 @@ auto Dictionarium::readWordList(const std::string& dictionaryName, const std::st
         WordSignature ws(normalizedWord.value());
         wordsNumber++;
         if(!ws.isSubsetOf(sourceSignature)) continue; //If the word is not a subset of the text to be anagrammed, skips it
+        if(!std::ranges::all_of(wordFilters, [&word](const WordFilter &filter) {return filter.accepts(word);})) continue;
         actualWordsNumber++;
 
         //Refreshes the length of the longest word
         if(wordLength > longestWordLength) longestWordLength = wordLength;
 
         //Pushes the word in the right section, with the corresponding signature-key
+        //Repeated lines are skipped, the search expands each word of a signature exactly once
         Section& rightSection = sections.at(wordLength);
-        rightSection[ws].push_back(word);
+        std::vector<std::string>& words = rightSection[ws];
+        if(std::ranges::contains(words, word)) {actualWordsNumber--; continue;}
+        words.push_back(word);
     }
 
     return wordsNumber;
@@ -95,6 +105,68 @@ const std::vector<int> Dictionarium::getAvailableLengths() const
     return availableLengths;
 }
 
+void Dictionarium::restrictLengths(const std::vector<int> &lengths)
+{
+    for(auto [i, s]: sections | std::views::enumerate)
+    {
+        if(s.empty() || std::ranges::contains(lengths, static_cast<int>(i))) continue;
+
+        for(const auto &entry : s) actualWordsNumber -= static_cast<unsigned int>(entry.second.size());
+        s = Section(); //Releases the memory as well
+    }
+}
+
+void Dictionarium::restrictLengthRange(int minLength, int maxLength)
+{
+    std::vector<int> lengths;
+    for(const int length : getAvailableLengths())
+    {
+        if(length >= minLength && length <= maxLength) lengths.push_back(length);
+    }
+    restrictLengths(lengths);
+}
+
+void Dictionarium::excludeWords(const std::vector<std::string> &words)
+{
+    for(const std::string &word : words)
+    {
+        auto normalizedWord = StringNormalizer::normalize(word);
+        if(!normalizedWord || normalizedWord.value().empty() || normalizedWord.value().length() >= MAX_WORD_LENGTH) continue;
+
+        Section &section = sections[normalizedWord.value().length()];
+        auto it = section.find(WordSignature(normalizedWord.value()));
+        if(it == section.end()) continue;
+
+        //Every spelling of the word goes, 'Roma' and 'roma', 'città' and 'citta'
+        std::vector<std::string> &entryWords = it->second;
+        const size_t removed = std::erase_if(entryWords, [&normalizedWord](const std::string &entryWord)
+        {
+            auto normalizedEntry = StringNormalizer::normalize(entryWord);
+            return normalizedEntry && normalizedEntry.value() == normalizedWord.value();
+        });
+
+        actualWordsNumber -= static_cast<unsigned int>(removed);
+        if(entryWords.empty()) section.erase(it); //The last entry takes its place
+    }
+}
+
+auto Dictionarium::excludeWordList(const std::string &fileName) -> std::expected<unsigned long, std::string>
+{
+    std::ifstream file(fileName, std::ios::in);
+    if(!file) {return std::unexpected("Cannot open file " + fileName);}
+
+    std::vector<std::string> words;
+    std::string word;
+    while(getline(file, word))
+    {
+        if(!word.empty()) words.push_back(word);
+    }
+
+    const unsigned long before = actualWordsNumber;
+    excludeWords(words);
+    return before - actualWordsNumber;
+}
+
 std::ostream& operator<<(std::ostream& os, const Dictionarium& dict)
 {
     for(const auto& section : dict.sections) //For every section (i.e. word length)
@@ -0,0 +1,211 @@
+#include <algorithm> //For std::min, std::ranges::sort, std::ranges::stable_sort, std::ranges::lower_bound
+#include <cstdint>   //For uint32_t, SIZE_MAX
+#include <cassert>   //For assert
+#include <vector>    //For std::vector
+#include <array>     //For std::array
+
+#include "LetterSearch.h"
+
+LetterIndex::LetterIndex(const Dictionarium &dictionary, const WordSignature &target, size_t query) : dictionary(dictionary), query(query)
+{
+    const int targetLength = target.getCharactersNumber();
+    std::array<size_t, LETTERS_NUMBER> counts = {};
+
+    for(int length=0; length<MAX_WORD_LENGTH; length++)
+    {
+        offsets[length] = static_cast<uint32_t>(entries.size());
+        if(length > targetLength) continue;
+
+        for(const SectionEntry &entry : dictionary.getSection(length).values())
+        {
+            const WordSignature &ws = entry.first;
+            if(ws.isSubsetOf(target))
+            {
+                for(size_t c=0; c<LETTERS_NUMBER; c++)
+                {
+                    if(ws.table[c] == 0) continue;
+                    lists[c].push_back(static_cast<uint32_t>(entries.size()));
+                    counts[c]++;
+                }
+            }
+            entries.push_back(&entry);
+        }
+    }
+
+    for(size_t c=0; c<LETTERS_NUMBER; c++)
+    {
+        if(target.table[c] > 0) letters.push_back(c);
+    }
+    std::ranges::stable_sort(letters, {}, [&counts](size_t c) {return counts[c];});
+}
+
+uint32_t LetterIndex::indexOf(const SectionEntry* entry) const
+{
+    const int length = entry->first.getCharactersNumber();
+    return offsets[length] + static_cast<uint32_t>(entry - dictionary.getSection(length).values().data());
+}
+
+//The subtrees of the first letter's entries are cut in ranges of the same size, as many as the granules of the policy
+std::vector<SearchTask> LetterIndex::schedule(size_t set, double cost, int workersNumber, SchedulePolicy policy) const
+{
+    std::vector<SearchTask> tasks;
+    if(letters.empty()) return tasks;
+
+    const size_t entriesNumber = lists[letters.front()].size();
+    const int granules = (policy == SchedulePolicy::FirstResults) ? FIRST_RESULTS_GRANULES : THROUGHPUT_GRANULES;
+    const size_t pieces = std::min(entriesNumber, static_cast<size_t>(workersNumber * granules));
+    for(size_t p=0; p<pieces; p++)
+    {
+        const size_t begin = entriesNumber * p / pieces;
+        const size_t end = entriesNumber * (p + 1) / pieces;
+        tasks.push_back({set, begin, end, 0, SIZE_MAX, cost * static_cast<double>(end - begin) / static_cast<double>(entriesNumber)});
+    }
+    return tasks;
+}
+
+LetterSearch::LetterSearch(ArmaMagna &am, const LetterIndex &index, const SearchTask &task)
+    : armaMagna(am), index(index), query(am.queries[index.getQuery()]), set(task.set), firstBegin(task.firstBegin), firstEnd(task.firstEnd),
+      cost(task.cost), maxDepth(query.maxCardinality), stopToken(am.stopSource.get_token())
+{
+    assert(maxDepth > 0);
+    remainders.resize(maxDepth + 1);
+    minIndices.resize(maxDepth + 1);
+    solution.resize(maxDepth);
+
+    batches.resize(maxDepth + 1);
+    for(int width=1; width<=maxDepth; width++)
+    {
+        batches[width].width = width;
+        batches[width].query = index.getQuery();
+        batches[width].dictionary = &am.dictionary;
+    }
+
+    splittable = (armaMagna.spawnTask != nullptr) && (armaMagna.checkpoint == nullptr);
+}
+
+void LetterSearch::operator()()
+{
+    remainders[0] = query.target;
+    minIndices[0].fill(0);
+
+    if(!index.getLetters().empty())
+    {
+        const size_t letter = index.getLetters().front();
+        const std::vector<uint32_t> &list = index.getList(letter);
+        for(firstCursor=firstBegin; firstCursor<firstEnd;)
+        {
+            if(splittable && armaMagna.workerPool->wantsWork()) split(false);
+            if(firstCursor >= firstEnd) break;
+
+            tryEntry(0, letter, list[firstCursor++]);
+            if(stopped) break;
+        }
+    }
+
+    for(int width=1; width<=maxDepth; width++) flushSolutions(width);
+}
+
+//Takes the rarest letter left, every solution has a word that contains it. The last word must be the whole
+//remainder, it's looked up instead
+void LetterSearch::search(int depth)
+{
+    const WordSignature &remainder = remainders[depth];
+    size_t letter = 0;
+    for(const size_t c : index.getLetters())
+    {
+        if(remainder.table[c] > 0) {letter = c; break;}
+    }
+
+    if(depth + 1 == maxDepth)
+    {
+        const int length = remainder.getCharactersNumber();
+        if(length >= MAX_WORD_LENGTH) return;
+
+        const Section &section = armaMagna.dictionary.getSection(length);
+        auto it = section.find(remainder);
+        if(it != section.end()) tryEntry(depth, letter, index.indexOf(&*it));
+        return;
+    }
+
+    const std::vector<uint32_t> &list = index.getList(letter);
+    for(auto it = std::ranges::lower_bound(list, minIndices[depth][letter]); it != list.end(); ++it)
+    {
+        if(stopped || (--stopCountdown == 0 && pollStop())) return;
+        if(depth == 1 && splittable && armaMagna.workerPool->wantsWork()) split(true);
+
+        tryEntry(depth, letter, *it);
+    }
+}
+
+//Places the entry as the word of the letter, if it fits the remainder and respects the smallest indices
+void LetterSearch::tryEntry(int depth, size_t letter, uint32_t entryIndex)
+{
+    const SectionEntry* entry = index.getEntry(entryIndex);
+    const WordSignature &ws = entry->first;
+    if(!ws.isSubsetOf(remainders[depth])) return;
+    for(size_t c=0; c<LETTERS_NUMBER; c++)
+    {
+        if(ws.table[c] > 0 && entryIndex < minIndices[depth][c]) return;
+    }
+
+    solution[depth] = entry;
+    remainders[depth + 1] = remainders[depth];
+    remainders[depth + 1] -= ws;
+    minIndices[depth + 1] = minIndices[depth];
+    minIndices[depth + 1][letter] = entryIndex;
+
+    if(remainders[depth + 1].getCharactersNumber() == 0)
+    {
+        if(depth + 1 >= query.minCardinality) emitSolution(depth + 1);
+    }
+    else if(depth + 1 < maxDepth)
+    {
+        search(depth + 1);
+    }
+}
+
+bool LetterSearch::pollStop()
+{
+    stopCountdown = LETTER_STOP_CHECK_NODES;
+    stopped = stopToken.stop_requested();
+    return stopped;
+}
+
+//Work stealing: while a worker is idle, the second half of the first letter's entries not yet started is given away
+//as a new task. Inside the subtree of an entry, the entry stays with the task
+void LetterSearch::split(bool inSubtree)
+{
+    const size_t left = firstEnd - firstCursor;
+    const size_t given = (left + (inSubtree ? 1 : 0)) / 2;
+    if(given == 0) return;
+
+    const double entryCost = cost / static_cast<double>(firstEnd - firstBegin);
+    SearchTask piece{set, firstEnd - given, firstEnd, 0, SIZE_MAX, entryCost * static_cast<double>(given)};
+    firstEnd -= given;
+    cost -= piece.cost;
+    armaMagna.spawnTask(piece);
+}
+
+//Solutions are batched by number of words. The expanders need repeated signatures on consecutive levels
+void LetterSearch::emitSolution(int width)
+{
+    ordered.assign(solution.begin(), solution.begin() + width);
+    std::ranges::sort(ordered);
+
+    SignatureBatch &batch = batches[width];
+    batch.entries.insert(batch.entries.end(), ordered.begin(), ordered.end());
+    if(batch.size() >= SIGNATURE_BATCH_TUPLES) flushSolutions(width);
+}
+
+void LetterSearch::flushSolutions(int width)
+{
+    SignatureBatch &batch = batches[width];
+    if(batch.entries.empty()) return;
+
+    armaMagna.solutionPipeline->push(std::move(batch));
+    batch = SignatureBatch();
+    batch.width = width;
+    batch.query = index.getQuery();
+    batch.dictionary = &armaMagna.dictionary;
+    batch.entries.reserve(SIGNATURE_BATCH_TUPLES * static_cast<size_t>(width));
+}
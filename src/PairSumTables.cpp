@@ -0,0 +1,68 @@
+#include <cstdint>    //For uint32_t
+#include <cstddef>   //For size_t
+#include <memory>   //For std::make_unique
+#include <vector>  //For std::vector
+#include <mutex>  //For std::call_once
+
+#include "WordSignature.h"
+#include "Dictionarium.h"
+#include "PairSumTables.h"
+
+PairSumTables::PairSumTables(const Dictionarium &dictionary, const WordSignature &bound, std::atomic<size_t> &usedMemory)
+    : dictionary(dictionary), bound(bound), usedMemory(usedMemory)
+{
+    //Empty, tables are built on demand
+}
+
+const PairSumTable* PairSumTables::get(int firstLength, int secondLength)
+{
+    std::call_once(builtFlags[firstLength][secondLength], &PairSumTables::build, this, firstLength, secondLength);
+    return tables[firstLength][secondLength].get();
+}
+
+//Sums every pair of entries that fits the bound. With equal lengths, only the pairs with first <= second are stored,
+//like the symmetry breaking of the search does. The memory is counted on the go from the capacities of the pair
+//lists, of the entries and of the buckets, and reserved from the shared budget row by row, so that tables built at
+//the same time can't overflow the cap together. A table that would overflow it is given up and its bytes released
+void PairSumTables::build(int firstLength, int secondLength)
+{
+    const std::vector<SectionEntry> &firstEntries = dictionary.getSection(firstLength).values();
+    const std::vector<SectionEntry> &secondEntries = dictionary.getSection(secondLength).values();
+
+    auto table = std::make_unique<PairSumTable>();
+    size_t pairsMemory = 0; //Bytes allocated by the pair lists
+    size_t reserved = 0;    //Bytes taken from the budget so far
+    WordSignature sum;
+    for(size_t i=0; i<firstEntries.size(); i++)
+    {
+        const WordSignature &first = firstEntries[i].first;
+        if(!first.isSubsetOf(bound)) continue;
+
+        for(size_t j=(firstLength == secondLength) ? i : 0; j<secondEntries.size(); j++)
+        {
+            sum = first;
+            sum += secondEntries[j].first;
+            if(!sum.isSubsetOf(bound)) continue;
+
+            std::vector<EntryPair> &pairs = table->try_emplace(sum).first->second;
+            const size_t capacity = pairs.capacity();
+            pairs.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(j)});
+            pairsMemory += (pairs.capacity() - capacity) * sizeof(EntryPair);
+        }
+
+        const size_t memory = pairsMemory + table->values().capacity() * sizeof(PairSumTable::value_type)
+                                          + table->bucket_count() * sizeof(PairSumTable::bucket_type);
+        if(memory > reserved)
+        {
+            const size_t grown = memory - reserved;
+            reserved = memory;
+            if(usedMemory.fetch_add(grown) + grown > PAIR_TABLES_MEMORY_CAP)
+            {
+                usedMemory -= reserved; //Too big, the search will scan instead
+                return;
+            }
+        }
+    }
+
+    tables[firstLength][secondLength] = std::move(table);
+}
@@ -1,115 +1,421 @@
-#include <algorithm> //For std::sort
+#include <algorithm> //For std::min, std::max, std::ranges::contains
+#include <cstdint>   //For uint32_t, uint64_t
 #include <cassert>   //For assert
-#include <string>    //For std::string
 #include <vector>    //For std::vector
-#include <mutex>     //For std::mutex, std::lock_guard
-#include <print>     //For std::println
-#include <set>       //For std::set std::multiset
 
 #include "SearchThread.h"
 
-SearchThread::SearchThread(ArmaMagna& am, const std::vector<int>& wl)
-    : armaMagna(am), wordLengths(wl), wordsNumber(static_cast<int>(wordLengths.size()))
+SearchThread::SearchThread(ArmaMagna& am, const PlannedSet& plannedSet, const SearchTask& task, const TaskProgress* resume)
+    : armaMagna(am), wordLengths(plannedSet.wordLengths), query(am.queries[plannedSet.query]), set(task.set), firstBegin((resume != nullptr) ? std::max(task.firstBegin, resume->cursor) : task.firstBegin),
+      firstEnd(task.firstEnd), secondBegin(task.secondBegin), secondEnd(task.secondEnd), taskId(task.id), resume(resume), cost(task.cost),
+      node(am.localNode()), dictionary(am.nodeDictionary(node)),
+      wordsNumber(static_cast<int>(wordLengths.size())), lastLevel(wordsNumber - 1), stopToken(am.stopSource.get_token()),
+      nextSeq((resume != nullptr) ? resume->entryBase : 0)
 {
-    //Modifies the size of the 'solution' vector, it will be filled with signatures that make a potential anagram
+    //Modifies the size of the 'solution' vector, it will be filled with the entries that make a potential anagram
     assert(wordsNumber > 0);
     solution.resize(wordsNumber);
+    remainders.resize(wordsNumber + 1);
+    cursors.resize(wordsNumber);
+    signatureBatch.width = wordsNumber;
+    signatureBatch.query = plannedSet.query;
+    signatureBatch.dictionary = &dictionary;
+    signatureBatch.entries.reserve(SIGNATURE_BATCH_TUPLES * static_cast<size_t>(wordsNumber));
 
-    for(size_t i=0; i<ws.table.size(); i++) assert(ws.table[i] == 0);
+    //Candidate lists never outgrow their section, so they are allocated once
+    //The last level has no list to filter, its only candidate is looked up directly
+    candidates.resize(wordsNumber * wordsNumber);
+    for(int depth=0; depth<wordsNumber; depth++)
+    {
+        for(int level=depth; level<lastLevel; level++)
+        {
+            candidates[depth * wordsNumber + level].reserve(dictionary.getSection(wordLengths[level]).size());
+        }
+    }
+    candidateList(lastLevel, lastLevel).reserve(1);
+
+    //With three words or more, the last two levels can be resolved together by a pair-sum table lookup
+    if(wordsNumber >= 3) pairTable = armaMagna.pairSumTables[node]->get(wordLengths[lastLevel - 1], wordLengths[lastLevel]);
+    listedLevels = (pairTable != nullptr) ? lastLevel - 1 : lastLevel;
+
+    //Best scores of a ranked search: an included text is part of every anagram, each level adds at most its section's best
+    ranking = (armaMagna.topAnagrams != nullptr);
+    if(ranking)
+    {
+        prefixScores.assign(wordsNumber + 1, query.bestIncludedScore);
+        suffixBounds.assign(wordsNumber + 1, 0.0);
+        for(int level=lastLevel; level>=0; level--) suffixBounds[level] = suffixBounds[level + 1] + armaMagna.wordScores.getSectionBest(wordLengths[level]);
+    }
+
+    //Depths whose subproblem is memoized: the listed ones below the first, whose deeper levels don't share the length
+    //of the previous level, so that no symmetry constraint crosses the boundary. 0 marks the others
+    //The lengths are keyed in the order the levels walk them: every query orders its levels by its own section sizes,
+    //and a hit is replayed level by level in the order of the plain search
+    //A ranked search prunes by a threshold that keeps rising, its subproblems are never complete, so nothing is memoized
+    suffixKeys.assign(wordsNumber, 0);
+    recordings.resize(wordsNumber);
+    for(int depth=1; depth<listedLevels && !ranking; depth++)
+    {
+        std::vector<int> suffix(wordLengths.begin() + depth, wordLengths.end());
+        if(suffix.size() > 10 || std::ranges::contains(suffix, wordLengths[depth - 1])) continue;
+
+        for(const int length : suffix) suffixKeys[depth] = (suffixKeys[depth] << 6) | static_cast<uint64_t>(length);
+    }
+    if(secondBegin > 0 || secondEnd < dictionary.getSection(wordLengths[std::min(1, lastLevel)]).size())
+    {
+        suffixKeys[std::min(1, lastLevel)] = 0; //A sliced second level doesn't cover its whole subproblem
+    }
+
+    //A checkpointed task must cut the same batches when it's resumed, so it's never split
+    splittable = (armaMagna.spawnTask != nullptr) && (armaMagna.checkpoint == nullptr);
 }   
 
 void SearchThread::operator()()
 {
+    explore();
+
+    //Solutions left over at the end of the task. A stopped task will be rerun by a resume, which must cut its batches
+    //the same way, so a checkpointed search drops its last, incomplete batch
+    if(stopped && armaMagna.checkpoint != nullptr) signatureBatch.entries.clear();
+    else                                           flushSolutions(true);
+}
+
+void SearchThread::explore()
+{
+    //The whole target is left at the top of the tree, the first lists hold the entries that fit it
+    remainders[0] = query.target;
+    if(lastLevel == 0 && !lookupLastLevel()) return; //Single word anagrams are a lookup of the whole target
+
+    for(int level=0; level<listedLevels; level++)
+    {
+        const Section& section = dictionary.getSection(wordLengths[level]);
+        const SectionEntry* begin = section.values().data();
+        const SectionEntry* end = begin + section.size();
+        if(level == 0) {end = begin + firstEnd; begin += firstBegin;}                                 //The first two levels only cover
+        if(level == 1) {end = begin + std::min(secondEnd, section.size()); begin += secondBegin;}     //the entries of their slice
+
+        std::vector<const SectionEntry*>& list = candidateList(0, level);
+        for(const SectionEntry* entry = begin; entry != end; ++entry)
+        {
+            if(entry->first.isSubsetOf(remainders[0])) list.push_back(entry);
+        }
+        if(list.empty()) return; //A level without candidates, nothing to search
+    }
+    if(listedLevels > 0) entryCost = cost / static_cast<double>(candidateList(0, 0).size());
+
     //Calls the searching algorithm with initial wordIndex 0
     //wordIndex tells us which integer of 'wordLenghts' shall be used
-    search(0);
+    if(armaMagna.searchEngine == SearchEngine::Iterative) searchIterative();
+    else                                                  search(0);
 }
 
 void SearchThread::search(int wordIndex)
 {
-    //Base case, possible solution found
+    //Base case, solution found: every entry fits what the previous ones left, and the lengths sum up to the target's
     assert(wordIndex <= wordsNumber);
     if(wordIndex == wordsNumber)
     {
-        if(ws == armaMagna.actualTargetSignature) computeSolution();
+        onSolution();
         return;
     }
 
-    //Iterates through every entry of the dictionary section contained in wordLengths[wordsIndex]
-    for(const auto& entry : armaMagna.dictionary.getSection(wordLengths[wordIndex]))
+    openLevel(wordIndex);
+    while(nextEntry(wordIndex))
     {
-        const WordSignature& currentSignature = entry.first; //Gets the current signature
+        search(wordIndex + 1); //Recursive call
+    }
+    closeLevel(wordIndex);
+}
 
-        ws += currentSignature;   //Adds the current entry's signature to ws
-        if(wordIndex >= 1)       //Pruning block
-        {
-            if(!ws.isSubsetOf(armaMagna.actualTargetSignature)) {ws -= currentSignature; continue;}
-        }
+//Same walk as search(), with an explicit stack: the per-depth state lives in the 'cursors' array
+void SearchThread::searchIterative()
+{
+    int depth = 0;
+    openLevel(0);
 
-        solution[wordIndex] = currentSignature; //Saves a pointer to the current signature in the 'solution' array
-        assert(wordIndex >= 0 && wordIndex < wordsNumber);
+    while(depth >= 0)
+    {
+        if(!nextEntry(depth)) {closeLevel(depth); depth--; continue;} //Level exhausted, backtracks to the previous one
 
-        search(wordIndex + 1); //Recursive call
+        if(depth + 1 == wordsNumber) {onSolution(); continue;} //Solution found
 
-        ws -= currentSignature; //Backtracking
+        depth++;
+        openLevel(depth);
     }
 }
 
-void SearchThread::computeSolution()
+//Sets the cursor of a level on its candidate list, computed when the previous level picked its entry
+void SearchThread::openLevel(int wordIndex)
 {
-    std::vector<std::string> anagram;
+    assert(wordIndex >= 0 && wordIndex < wordsNumber);
+    const std::vector<const SectionEntry*>& list = candidateList(wordIndex, wordIndex);
 
-    //Adds the included words to the vector, if there's any
-    if(armaMagna.includedText != "")
+    LevelCursor& cursor = cursors[wordIndex];
+    cursor.current = list.data();
+    cursor.end = list.data() + list.size();
+}
+
+//Moves the cursor to the next candidate, adds it to the partial solution and compacts the candidate lists of the deeper
+//levels to the entries that still fit the remainder. Candidates whose remainder leaves a deeper level empty are pruned
+//Returns false when the level is exhausted
+bool SearchThread::nextEntry(int wordIndex)
+{
+    LevelCursor& cursor = cursors[wordIndex];
+    while(cursor.current != cursor.end)
     {
-        anagram.push_back(armaMagna.includedText);
+        if(stopped || (--stopCountdown == 0 && pollStop())) return false; //Every level unwinds at once
+        if(wordIndex < 2 && splittable && armaMagna.workerPool->wantsWork()) split(wordIndex);
+
+        const SectionEntry* entry = *cursor.current++;
+
+        //Every candidate fits the remainder, by construction
+        remainders[wordIndex + 1] = remainders[wordIndex];
+        remainders[wordIndex + 1] -= entry->first;
+        solution[wordIndex] = entry; //Saves a pointer to the current entry in the 'solution' array
+
+        if(ranking && !canRank(wordIndex, entry)) continue;
+        if(filterCandidates(wordIndex, entry)) return true;
     }
+    return false;
+}
 
-    //Adds the found words to the set
-    outputSolution(anagram, 0); //Recursive function
+bool SearchThread::pollStop()
+{
+    stopCountdown = STOP_CHECK_NODES;
+    stopped = stopToken.stop_requested();
+    return stopped;
 }
 
-void SearchThread::outputSolution(std::vector<std::string>& anagram, int index)
+//Work stealing: while a worker is idle, the second half of what is left to start on the shallowest of the first two
+//levels is given away as a new task, with the same slices otherwise. The entry a level is searching stays with it.
+//The first level piece is a range of first level entries, the second level piece a range of second level entries
+//for the current first level entry, whose subproblem is then incomplete and not memoized
+void SearchThread::split(int wordIndex)
 {
-    //Base case
-    assert(index <= wordsNumber);
-    if(index == wordsNumber)
+    for(int level=0; level<=wordIndex && level<listedLevels; level++)
     {
-        std::vector<std::string> orderedAnagram = anagram;
-        std::string canonicalString;
-        bool shouldPush = false;
+        LevelCursor& cursor = cursors[level];
+        const size_t left = static_cast<size_t>(cursor.end - cursor.current);
+        const size_t given = (left + ((level < wordIndex) ? 1 : 0)) / 2;
+        if(given == 0) continue;
 
-        //Formats the output string
-        std::sort(orderedAnagram.begin(), orderedAnagram.end());
-        for(const std::string& word : orderedAnagram) {canonicalString += word; canonicalString += " ";}
-        assert(!canonicalString.empty());  
-        canonicalString.pop_back(); //Trailing space is removed
+        const SectionEntry* const* middle = cursor.end - given;
+        const SectionEntry* sectionBegin = dictionary.getSection(wordLengths[level]).values().data();
+        const size_t middleIndex = static_cast<size_t>(*middle - sectionBegin);
 
-        //PRODUCER CRITICAL SECTION
+        SearchTask piece{set, middleIndex, firstEnd, secondBegin, secondEnd, entryCost * static_cast<double>(given), taskId};
+        if(level == 0)
+        {
+            firstEnd = middleIndex;
+        }
+        else
         {
-            std::lock_guard lock(armaMagna.anagramQueueMutex);
+            //The end of the list may have been given away already, for this entry
+            const std::vector<const SectionEntry*>& list = candidateList(1, 1);
+            const size_t entryIndex = static_cast<size_t>(solution[0] - dictionary.getSection(wordLengths[0]).values().data());
+            const size_t pieceEnd = (cursor.end == list.data() + list.size()) ? secondEnd : static_cast<size_t>(*cursor.end - sectionBegin);
+            piece = {set, entryIndex, entryIndex + 1, middleIndex, pieceEnd, piece.cost / static_cast<double>(list.size()), taskId};
+            recordings[1].overflow = true;
+        }
 
-            if(anagramSet.insert(canonicalString).second) //If the insertion took place, it's a new anagram
+        cursor.end = middle;
+        cost -= piece.cost;
+        armaMagna.spawnTask(piece);
+        return;
+    }
+}
+
+//Branch and bound: every level left can add at most the best score of its section. An entry whose optimistic bound
+//can't reach the threshold of the top anagrams is pruned, with its whole subtree
+bool SearchThread::canRank(int wordIndex, const SectionEntry* entry)
+{
+    const size_t index = static_cast<size_t>(entry - dictionary.getSection(wordLengths[wordIndex]).values().data());
+    prefixScores[wordIndex + 1] = prefixScores[wordIndex] + armaMagna.wordScores.getEntryBest(wordLengths[wordIndex], index);
+
+    return armaMagna.topAnagrams->canReach(prefixScores[wordIndex + 1] + suffixBounds[wordIndex + 1]);
+}
+
+//Builds the candidate lists of depth wordIndex+1 from the ones of depth wordIndex
+//Symmetry breaking: consecutive levels with the same length pick non-decreasing entries, so every multiset of
+//signatures is visited once, and slices of a set never overlap
+bool SearchThread::filterCandidates(int wordIndex, const SectionEntry* entry)
+{
+    const int depth = wordIndex + 1;
+    const WordSignature& remainder = remainders[depth];
+    if(depth == wordsNumber) return true; //Nothing below the last level
+    if(depth == lastLevel) return lookupLastLevel();
+    if(depth == listedLevels) return lookupPairs();
+    if(suffixKeys[depth] != 0 && probeMemo(depth)) return false; //Subproblem already solved, no need to descend
+
+    bool sameLength = true; //True while the deeper levels share the length of the current one
+    for(int level=depth; level<listedLevels; level++)
+    {
+        sameLength = sameLength && (wordLengths[level] == wordLengths[wordIndex]);
+
+        const std::vector<const SectionEntry*>& source = candidateList(wordIndex, level);
+        std::vector<const SectionEntry*>& list = candidateList(depth, level);
+        list.clear();
+
+        auto it = source.begin();
+        if(sameLength) it = std::lower_bound(source.begin(), source.end(), entry); //Same section, sorted by address
+        for(; it != source.end(); ++it)
+        {
+            if((*it)->first.isSubsetOf(remainder)) list.push_back(*it);
+        }
+        if(list.empty()) {closeLevel(depth); return false;} //Dead end, recorded as such if memoized
+    }
+    return true;
+}
+
+//Looks the subproblem of a depth up in the transposition table. On a hit, its completions are output right away.
+//On a miss, the solutions found below the depth start being recorded, until the depth is closed
+bool SearchThread::probeMemo(int depth)
+{
+    MemoRecording& recording = recordings[depth];
+    recording.key.remainder = remainders[depth];
+    recording.key.lengths = suffixKeys[depth];
+
+    if(armaMagna.transpositionTable.probe(recording.key, memoHit))
+    {
+        const size_t width = static_cast<size_t>(wordsNumber - depth);
+        for(size_t first=0; first<memoHit.size(); first+=width)
+        {
+            for(size_t i=0; i<width; i++)
             {
-                armaMagna.anagramQueue.push(std::move(canonicalString)); //Result is pushed to the I/O queue
-                shouldPush = true;
+                const uint32_t packed = memoHit[first + i];
+                solution[depth + i] = dictionary.getSection(packedLength(packed)).values().data() + packedIndex(packed);
             }
-        } //Critical section ends
+            onSolution();
+        }
+        return true;
+    }
 
-        if(shouldPush) armaMagna.anagramQueueCV.notify_one(); //If the anagram is not new, don't notify
-        return;
+    recording.active = true;
+    recording.overflow = false;
+    recording.completions.clear();
+    return false;
+}
+
+//Stores what the subproblem of a depth turned out to be, if it was being recorded
+//A subproblem cut short by a stop request is incomplete, so it is never stored
+void SearchThread::closeLevel(int depth)
+{
+    MemoRecording& recording = recordings[depth];
+    if(!recording.active) return;
+
+    recording.active = false;
+    if(!recording.overflow && !stopped) armaMagna.transpositionTable.store(recording.key, recording.completions);
+}
+
+//Every solution is appended to the recordings of the open subproblems, then output
+void SearchThread::onSolution()
+{
+    for(int depth=1; depth<lastLevel; depth++)
+    {
+        MemoRecording& recording = recordings[depth];
+        if(!recording.active || recording.overflow) continue;
+
+        const size_t width = static_cast<size_t>(wordsNumber - depth);
+        if(recording.completions.size() >= MAX_MEMO_COMPLETIONS * width) {recording.overflow = true; continue;}
+
+        for(int level=depth; level<wordsNumber; level++)
+        {
+            const Section& section = dictionary.getSection(wordLengths[level]);
+            recording.completions.push_back(packEntry(wordLengths[level], static_cast<size_t>(solution[level] - section.values().data())));
+        }
     }
 
-    //Recursive part
-    assert(index < static_cast<int>(solution.size()));
-    const WordSignature& wordSignature = solution[index];
-    const std::vector<std::string> &words = armaMagna.dictionary.getWords(wordSignature);
-    for(const std::string &word : words)
+    emitSolution();
+}
+
+//The last word must be exactly what is left of the target: instead of scanning the last section, the remainder
+//is looked up in it. Its candidate list holds the entry found, if any and if it respects the symmetry breaking
+bool SearchThread::lookupLastLevel()
+{
+    std::vector<const SectionEntry*>& list = candidateList(lastLevel, lastLevel);
+    list.clear();
+
+    const Section& section = dictionary.getSection(wordLengths[lastLevel]);
+    auto it = section.find(remainders[lastLevel]);
+    if(it == section.end()) return false;
+
+    const SectionEntry* entry = &*it;
+    if(!inSlice(lastLevel, entry)) return false;
+    if(lastLevel > 0 && wordLengths[lastLevel] == wordLengths[lastLevel - 1] && entry < solution[lastLevel - 1]) return false;
+
+    list.push_back(entry);
+    return true;
+}
+
+//Meet-in-the-middle: the pairs of entries of the last two levels whose sum is the remainder come from one lookup.
+//The candidates of the second to last level are the first entries of those pairs; each one leaves a remainder
+//that the last level is sure to find
+bool SearchThread::lookupPairs()
+{
+    const int level = lastLevel - 1;
+    std::vector<const SectionEntry*>& list = candidateList(level, level);
+    list.clear();
+
+    auto it = pairTable->find(remainders[level]);
+    if(it == pairTable->end()) return false;
+
+    const SectionEntry* sectionBegin = dictionary.getSection(wordLengths[level]).values().data();
+    const bool sameLength = (wordLengths[level] == wordLengths[level - 1]);
+    for(const EntryPair& pair : it->second)
     {
-        anagram.push_back(word);
+        const SectionEntry* entry = sectionBegin + pair.first;
+        if(sameLength && entry < solution[level - 1]) continue; //Symmetry breaking
+        if(!inSlice(level, entry)) continue;
+        list.push_back(entry);
+    }
+    return !list.empty();
+}
+
+//True if the entry is in the slice of its level, only the first two levels are sliced
+bool SearchThread::inSlice(int level, const SectionEntry* entry) const
+{
+    if(level > 1) return true;
 
-        outputSolution(anagram, index + 1); //Recursive call
+    const size_t index = static_cast<size_t>(entry - dictionary.getSection(wordLengths[level]).values().data());
+    if(level == 0) return index >= firstBegin && index < firstEnd;
+    return index >= secondBegin && index < secondEnd;
+}
 
-        anagram.pop_back();                        //O(1) vector backtracking
+//The search only finds tuples of signatures, the words are expanded by the pipeline. Batches never span two first level
+//entries, so that a resumed search can restart from an entry boundary. The search of a task is deterministic, memo hits
+//and pair lookups yield their solutions in the order of the plain search, so a rerun cuts and numbers the same batches
+void SearchThread::emitSolution()
+{
+    if(solution[0] != batchEntry)
+    {
+        flushSolutions(true);
+        batchEntry = solution[0];
+        entryBase = nextSeq;
     }
+
+    signatureBatch.entries.insert(signatureBatch.entries.end(), solution.begin(), solution.end());
+    if(signatureBatch.size() >= SIGNATURE_BATCH_TUPLES) flushSolutions(false);
+}
+
+void SearchThread::flushSolutions(bool lastOfEntry)
+{
+    if(signatureBatch.entries.empty()) return;
+
+    BatchTag& tag = signatureBatch.tag;
+    tag.task = taskId;
+    tag.seq = nextSeq++;
+    tag.entry = static_cast<size_t>(batchEntry - dictionary.getSection(wordLengths[0]).values().data());
+    tag.entryBase = entryBase;
+    tag.lastOfEntry = lastOfEntry;
+
+    //Batches a previous run already wrote to the output file are dropped
+    if(resume != nullptr && resume->isWritten(tag.seq)) {signatureBatch.entries.clear(); return;}
+
+    armaMagna.solutionPipeline->push(std::move(signatureBatch));
+    const size_t queryIndex = signatureBatch.query;
+    signatureBatch = SignatureBatch();
+    signatureBatch.width = wordsNumber;
+    signatureBatch.query = queryIndex;
+    signatureBatch.dictionary = &dictionary;
+    signatureBatch.entries.reserve(SIGNATURE_BATCH_TUPLES * static_cast<size_t>(wordsNumber));
 }
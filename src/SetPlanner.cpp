@@ -0,0 +1,256 @@
+#include <algorithm>  //For std::min, std::max, std::ranges::sort, std::ranges::stable_sort, std::ranges::min_element
+#include <cassert>   //For assert
+#include <climits>  //For UINT8_MAX
+#include <cstdint> //For SIZE_MAX, uint8_t
+#include <ranges>  //For std::views::enumerate, std::views::take
+#include <cmath>  //For std::pow, std::ceil
+#include <vector> //For std::vector
+#include <array> //For std::array
+
+#include "WordSignature.h"
+#include "Dictionarium.h"
+#include "SetPlanner.h"
+
+SetPlanner::SetPlanner(const Dictionarium &dictionary, const WordSignature &target)
+    : target(target), targetLength(target.getCharactersNumber()), dictionary(dictionary)
+{
+    //Only the signatures that fit the actual target can ever take part in a solution
+    for(const int length : dictionary.getAvailableLengths())
+    {
+        SectionStats &s = stats[length];
+        s.minUsage.table.fill(UINT8_MAX);
+        for(const auto &entry : dictionary.getSection(length))
+        {
+            const WordSignature &ws = entry.first;
+            if(!ws.isSubsetOf(this->target)) continue;
+
+            s.filteredSize++;
+            for(size_t c=0; c<ws.table.size(); c++)
+            {
+                s.minUsage.table[c] = std::min(s.minUsage.table[c], ws.table[c]);
+                s.maxUsage.table[c] = std::max(s.maxUsage.table[c], ws.table[c]);
+            }
+        }
+        if(s.filteredSize == 0) s.minUsage.table.fill(0);
+    }
+}
+
+//The search tree of a set has one level per word: every surviving node at level d scans the candidates of level d,
+//except at the last level, which is a single lookup of the remainder.
+//Survivors are the product of the filtered section sizes, corrected by the probability that a word still fits
+//into what is left of the target once the previous levels consumed their letters.
+double SetPlanner::estimateCost(const std::vector<int> &wordLengths) const
+{
+    assert(targetLength > 0);
+
+    double cost = 0.0;
+    double survivors = 1.0;  //Estimated number of nodes reaching the current level
+    int consumed = 0;        //Letters used by the previous levels
+
+    for(const int length : wordLengths | std::views::take(wordLengths.size() - 1))
+    {
+        const double sectionSize = static_cast<double>(stats[length].filteredSize);
+        cost += survivors * sectionSize;
+
+        //Pruning correction: every letter of the word must find a free copy in the remaining target
+        const double freeFraction = static_cast<double>(targetLength - consumed) / targetLength;
+        survivors *= sectionSize * std::pow(freeFraction, length);
+        consumed += length;
+    }
+    cost += survivors; //Last level lookups
+
+    return cost;
+}
+
+//The branching factor of the search tree is set by its top levels: the most selective (smallest) sections go first,
+//the largest one goes last, where it costs the least. Ties are broken by length, so that repeated lengths stay
+//consecutive and their symmetry can still be handled level by level.
+std::vector<int> SetPlanner::orderLevels(const std::vector<int> &wordLengths) const
+{
+    std::vector<int> ordered = wordLengths;
+    std::ranges::sort(ordered, [this](int a, int b)
+        {
+            if(stats[a].filteredSize != stats[b].filteredSize) return stats[a].filteredSize < stats[b].filteredSize;
+            return a < b;
+        }
+    );
+    return ordered;
+}
+
+//Cheap necessary conditions, from the cheapest to the most expensive:
+//1) every level has at least one signature that fits the target
+//2) the letters that the levels are forced to use fit the target, and the letters they can reach cover it
+//3) every level still has a signature that fits once the other levels took their forced letters
+bool SetPlanner::isFeasible(const std::vector<int> &wordLengths)
+{
+    //The sums are kept in ints, with many levels they would wrap around the 8-bit counters of a signature
+    std::array<int, 26> forced = {}, reachable = {};
+    for(const int length : wordLengths)
+    {
+        if(stats[length].filteredSize == 0) return false;
+        for(size_t c=0; c<target.table.size(); c++)
+        {
+            forced[c] += stats[length].minUsage.table[c];
+            reachable[c] += stats[length].maxUsage.table[c];
+        }
+    }
+    for(size_t c=0; c<target.table.size(); c++)
+    {
+        if(forced[c] > target.table[c] || reachable[c] < target.table[c]) return false;
+    }
+
+    for(const int length : wordLengths)
+    {
+        //residual = target - (forced - minUsage[length]), forced fits the target so nothing wraps
+        WordSignature residual(target);
+        for(size_t c=0; c<target.table.size(); c++) residual.table[c] -= static_cast<uint8_t>(forced[c] - stats[length].minUsage.table[c]);
+        if(!sectionFits(length, residual)) return false;
+    }
+
+    return true;
+}
+
+//True if the section holds at least one signature that is a subset of 'residual'
+bool SetPlanner::sectionFits(int length, const WordSignature &residual)
+{
+    auto [it, inserted] = fitsMemo[length].try_emplace(residual, false);
+    if(!inserted) return it->second;
+
+    for(const auto &entry : dictionary.getSection(length))
+    {
+        if(entry.first.isSubsetOf(residual)) {it->second = true; break;}
+    }
+    return it->second;
+}
+
+//Throughput: largest first, so that the heavy sets don't start last. The sets costing more than a quarter of a worker's
+//share are split, so that the run doesn't end with a few cores busy on the giant sets while the others sit idle.
+//First results: cheapest first, and everything costing more than a small granule is split, so that each worker gets
+//a short task at once and the first anagrams show up immediately.
+std::vector<SearchTask> SetPlanner::schedule(const std::vector<PlannedSet> &plannedSets, SchedulePolicy policy, int workersNumber, double searchCost) const
+{
+    std::vector<SearchTask> tasks;
+    tasks.reserve(plannedSets.size());
+
+    double totalCost = searchCost;
+    if(totalCost == 0.0) for(const PlannedSet &plannedSet : plannedSets) totalCost += plannedSet.cost;
+    const int granules = (policy == SchedulePolicy::FirstResults) ? FIRST_RESULTS_GRANULES : THROUGHPUT_GRANULES;
+    const double granule = totalCost / (workersNumber * granules);
+
+    for(const auto [i, plannedSet] : plannedSets | std::views::enumerate)
+    {
+        size_t pieces = 1;
+        if(granule > 0 && plannedSet.cost > granule) pieces = static_cast<size_t>(std::ceil(plannedSet.cost / granule));
+        split(plannedSet, static_cast<size_t>(i), pieces, tasks);
+    }
+
+    order(tasks, policy);
+    return tasks;
+}
+
+void SetPlanner::order(std::vector<SearchTask> &tasks, SchedulePolicy policy)
+{
+    if(policy == SchedulePolicy::Throughput) std::ranges::stable_sort(tasks, std::ranges::greater{}, &SearchTask::cost);
+    else                                     std::ranges::stable_sort(tasks, std::ranges::less{}, &SearchTask::cost);
+    for(size_t i=0; i<tasks.size(); i++) tasks[i].id = i;
+}
+
+//The slices are balanced on the entries that fit the target, the others are skipped by the search anyway.
+//Depth 1: ranges of first level entries. Depth 2, when the first level has fewer fitting entries than pieces and
+//there are at least three words: every first level entry gets its own tasks, each with a range of second level entries
+void SetPlanner::split(const PlannedSet &plannedSet, size_t set, size_t pieces, std::vector<SearchTask> &tasks) const
+{
+    const std::vector<int> &wordLengths = plannedSet.wordLengths;
+    const std::vector<SectionEntry> &firstEntries = dictionary.getSection(wordLengths[0]).values();
+
+    std::vector<size_t> fitting; //Indices of the first level entries that fit the target
+    for(size_t i=0; i<firstEntries.size(); i++)
+    {
+        if(firstEntries[i].first.isSubsetOf(target)) fitting.push_back(i);
+    }
+
+    //Cuts 'indices' in 'n' ranges with the same number of indices, covering [0, size)
+    auto slice = [](const std::vector<size_t> &indices, size_t n, size_t size, auto &&emit)
+    {
+        for(size_t p=0; p<n; p++)
+        {
+            const size_t begin = (p == 0) ? 0 : indices[indices.size() * p / n];
+            const size_t end = (p + 1 == n) ? size : indices[indices.size() * (p + 1) / n];
+            const size_t count = indices.size() * (p + 1) / n - indices.size() * p / n;
+            emit(begin, end, static_cast<double>(count) / static_cast<double>(indices.size()));
+        }
+    };
+
+    if(pieces <= 1 || fitting.empty())
+    {
+        tasks.push_back({set, 0, firstEntries.size(), 0, SIZE_MAX, plannedSet.cost});
+        return;
+    }
+
+    if(pieces <= fitting.size() || wordLengths.size() < 3)
+    {
+        slice(fitting, std::min(pieces, fitting.size()), firstEntries.size(), [&](size_t begin, size_t end, double share)
+            {
+                tasks.push_back({set, begin, end, 0, SIZE_MAX, plannedSet.cost * share});
+            }
+        );
+        return;
+    }
+
+    const std::vector<SectionEntry> &secondEntries = dictionary.getSection(wordLengths[1]).values();
+    const size_t piecesPerEntry = (pieces + fitting.size() - 1) / fitting.size();
+    const size_t firstTask = tasks.size();
+    for(const size_t i : fitting)
+    {
+        WordSignature remainder(target);
+        remainder -= firstEntries[i].first;
+
+        std::vector<size_t> secondFitting; //Second level entries that fit what the first one leaves
+        for(size_t j=(wordLengths[1] == wordLengths[0]) ? i : 0; j<secondEntries.size(); j++)
+        {
+            if(secondEntries[j].first.isSubsetOf(remainder)) secondFitting.push_back(j);
+        }
+        if(secondFitting.empty()) continue;
+
+        const double entryCost = plannedSet.cost / static_cast<double>(fitting.size());
+        slice(secondFitting, std::min(piecesPerEntry, secondFitting.size()), secondEntries.size(), [&](size_t begin, size_t end, double share)
+            {
+                tasks.push_back({set, i, i + 1, begin, end, entryCost * share});
+            }
+        );
+    }
+
+    if(tasks.size() == firstTask) tasks.push_back({set, 0, firstEntries.size(), 0, SIZE_MAX, plannedSet.cost}); //Nothing fits
+}
+
+//LPT over the whole schedule: the tasks are dealt from the most expensive to the least loaded shard, ties broken by
+//task and by shard index. Every process computes the same schedule, so the shards are disjoint and cover it all
+std::vector<SearchTask> SetPlanner::shard(const std::vector<SearchTask> &tasks, int shardIndex, int shardsNumber)
+{
+    assert(shardIndex >= 1 && shardIndex <= shardsNumber);
+
+    std::vector<const SearchTask*> byCost;
+    for(const SearchTask &task : tasks) byCost.push_back(&task);
+    std::ranges::stable_sort(byCost, [](const SearchTask* a, const SearchTask* b) {return a->cost > b->cost;});
+
+    std::vector<double> loads(static_cast<size_t>(shardsNumber), 0.0);
+    std::vector<bool> mine(tasks.size(), false);
+    for(const SearchTask* task : byCost)
+    {
+        const size_t lightest = static_cast<size_t>(std::ranges::min_element(loads) - loads.begin());
+        loads[lightest] += task->cost;
+        mine[task->id] = (lightest == static_cast<size_t>(shardIndex - 1));
+    }
+
+    std::vector<SearchTask> shardTasks;
+    for(const SearchTask &task : tasks)
+    {
+        if(mine[task.id]) shardTasks.push_back(task);
+    }
+    return shardTasks;
+}
+
+const SectionStats& SetPlanner::getStats(int length) const
+{
+    return stats[length];
+}
@@ -0,0 +1,233 @@
+#include <string_view> //For std::string_view
+#include <algorithm>  //For std::ranges::sort, std::ranges::max
+#include <cassert>   //For assert
+#include <string>    //For std::string
+#include <vector>    //For std::vector
+#include <memory>    //For std::make_unique
+#include <mutex>     //For std::mutex, std::lock_guard, std::unique_lock
+#include <span>      //For std::span
+
+#include "SolutionPipeline.h"
+#include "ArmaMagna.h"
+
+SolutionPipeline::SolutionPipeline(ArmaMagna &am, int expandersNumber) : armaMagna(am)
+{
+    assert(expandersNumber > 0);
+    for(int i=0; i<expandersNumber; i++) expanders.emplace_back(&SolutionPipeline::expanderLoop, this);
+}
+
+SolutionPipeline::~SolutionPipeline()
+{
+    close();
+}
+
+void SolutionPipeline::push(SignatureBatch &&batch)
+{
+    {
+        std::unique_lock lock(batchesMutex);
+        notFullCV.wait(lock, [this] {return batches.size() < PIPELINE_CAPACITY;}); //Backpressure on the search threads
+        batches.push(std::move(batch));
+    }
+    notEmptyCV.notify_one();
+}
+
+void SolutionPipeline::close()
+{
+    {
+        std::lock_guard lock(batchesMutex);
+        closed = true;
+    }
+    notEmptyCV.notify_all();
+
+    for(std::jthread &expander : expanders)
+    {
+        if(expander.joinable()) expander.join();
+    }
+}
+
+//Pops batches until the pipeline is closed and empty, and expands every tuple they hold. The anagrams are handed to
+//the I/O thread when the local batch is full, or before waiting for more work, so that none of them is held back.
+//Every anagram batch carries the tags of the signature batches it completes
+void SolutionPipeline::expanderLoop()
+{
+    ExpanderState state;
+    while(true)
+    {
+        bool idle;
+        {
+            std::lock_guard lock(batchesMutex);
+            idle = batches.empty();
+        }
+        if(idle) flushAnagrams(state);
+
+        SignatureBatch batch;
+        {
+            std::unique_lock lock(batchesMutex);
+            notEmptyCV.wait(lock, [this] {return !batches.empty() || closed;});
+            if(batches.empty()) break; //Closed and drained
+            batch = std::move(batches.front());
+            batches.pop();
+        }
+        notFullCV.notify_one();
+
+        if(armaMagna.stopSource.stop_requested()) continue; //The batches left are drained without being expanded
+
+        //Every alternative of the query whose cardinalities allow the width of the set gets its anagrams
+        const std::span<const SectionEntry* const> entries(batch.entries);
+        state.dictionary = batch.dictionary;
+        for(const size_t a : armaMagna.queries[batch.query].alternatives)
+        {
+            const Alternative &alternative = armaMagna.alternatives[a];
+            if(batch.width < alternative.minCardinality || batch.width > alternative.maxCardinality) continue;
+
+            for(size_t i=0; i<batch.size(); i++)
+            {
+                expand(entries.subspan(i * static_cast<size_t>(batch.width), static_cast<size_t>(batch.width)), alternative, state);
+            }
+        }
+        state.anagrams.tags.push_back(batch.tag);
+
+        //Checkpointed searches only flush between signature batches, so that every anagram batch holds whole ones
+        if(armaMagna.checkpoint != nullptr && state.anagrams.bytes() >= ANAGRAM_BATCH_BYTES) flushAnagrams(state);
+    }
+    flushAnagrams(state);
+}
+
+void SolutionPipeline::expand(std::span<const SectionEntry* const> tuple, const Alternative &alternative, ExpanderState &state)
+{
+    state.anagram.clear();
+    state.alternative = &alternative;
+
+    //Adds the included words to the vector, if there's any
+    if(alternative.includedText != "")
+    {
+        state.anagram.push_back(alternative.includedText);
+    }
+
+    //A ranked search only keeps the best anagrams, the words are bounded like the signatures
+    if(armaMagna.topAnagrams != nullptr)
+    {
+        state.wordScores.clear();
+        state.tupleBounds.assign(tuple.size() + 1, 0.0);
+        for(const SectionEntry* entry : tuple)
+        {
+            const int length = entry->first.getCharactersNumber();
+            const size_t index = static_cast<size_t>(entry - state.dictionary->getSection(length).values().data());
+            state.wordScores.push_back(&armaMagna.wordScores.getWordScores(length, index));
+        }
+        for(size_t i=tuple.size(); i-- > 0;) state.tupleBounds[i] = state.tupleBounds[i + 1] + std::ranges::max(*state.wordScores[i]);
+
+        expandTop(tuple, state, 0, 0, alternative.includedScore);
+        return;
+    }
+
+    //Adds the found words to the set
+    if(armaMagna.searchEngine == SearchEngine::Iterative) expandIterative(tuple, state);
+    else                                                  expandRecursive(tuple, state, 0, 0); //Recursive function
+}
+
+//Expands the signatures of the solution into words. A signature repeated on consecutive levels takes non-decreasing
+//word indices, so that each multiset of words is generated once and no deduplication is needed
+void SolutionPipeline::expandRecursive(std::span<const SectionEntry* const> tuple, ExpanderState &state, size_t index, size_t firstWord)
+{
+    //Base case
+    assert(index <= tuple.size());
+    if(index == tuple.size())
+    {
+        pushAnagram(state);
+        return;
+    }
+
+    //Recursive part
+    const SectionEntry* entry = tuple[index];
+    const bool repeatsNext = (index + 1 < tuple.size()) && (tuple[index + 1] == entry);
+    const std::vector<std::string> &words = entry->second;
+    for(size_t i=firstWord; i<words.size(); i++)
+    {
+        state.anagram.push_back(words[i]);
+
+        expandRecursive(tuple, state, index + 1, repeatsNext ? i : 0); //Recursive call
+
+        state.anagram.pop_back();                        //O(1) vector backtracking
+    }
+}
+
+//Non-recursive version of expandRecursive: an odometer over the word indices of every level,
+//with the same non-decreasing constraint on repeated signatures
+void SolutionPipeline::expandIterative(std::span<const SectionEntry* const> tuple, ExpanderState &state)
+{
+    const size_t prefixSize = state.anagram.size(); //Included text, if any
+    const size_t width = tuple.size();
+    std::vector<size_t> &wordCursors = state.wordCursors;
+    wordCursors.assign(width, 0);
+
+    while(true)
+    {
+        state.anagram.resize(prefixSize);
+        for(size_t i=0; i<width; i++) state.anagram.push_back(tuple[i]->second[wordCursors[i]]);
+        pushAnagram(state);
+
+        //Increments the odometer, starting from the last level
+        size_t i = width;
+        while(i > 0 && ++wordCursors[i - 1] == tuple[i - 1]->second.size()) i--;
+        if(i == 0) break;
+
+        //Resets the following levels, repeated signatures restart from the previous level's word
+        for(size_t j=i; j<width; j++) wordCursors[j] = (tuple[j] == tuple[j - 1]) ? wordCursors[j - 1] : 0;
+    }
+}
+
+//Same walk as expandRecursive, pruned like the search: a prefix whose best completion can't reach the threshold of
+//the top anagrams is skipped. Only the anagrams that rank are formatted
+void SolutionPipeline::expandTop(std::span<const SectionEntry* const> tuple, ExpanderState &state, size_t index, size_t firstWord, double score)
+{
+    if(!armaMagna.topAnagrams->canReach(score + state.tupleBounds[index])) return;
+
+    //Base case
+    if(index == tuple.size())
+    {
+        if(score < armaMagna.topAnagrams->getThreshold()) return;
+
+        state.ordered.assign(state.anagram.begin(), state.anagram.end());
+        std::ranges::sort(state.ordered);
+        std::string text;
+        if(armaMagna.taggedOutput) {text += state.alternative->includedText; text += '\t';}
+        for(const std::string_view word : state.ordered) {text += word; text += ' ';}
+        text.pop_back();
+        armaMagna.topAnagrams->offer(score, std::move(text));
+        return;
+    }
+
+    //Recursive part
+    const SectionEntry* entry = tuple[index];
+    const bool repeatsNext = (index + 1 < tuple.size()) && (tuple[index + 1] == entry);
+    const std::vector<std::string> &words = entry->second;
+    const std::vector<double> &scores = *state.wordScores[index];
+    for(size_t i=firstWord; i<words.size(); i++)
+    {
+        state.anagram.push_back(words[i]);
+
+        expandTop(tuple, state, index + 1, repeatsNext ? i : 0, score + scores[i]); //Recursive call
+
+        state.anagram.pop_back();
+    }
+}
+
+//Formats an anagram into the local batch, sorting its words. With several included texts, its own comes first as a tag
+void SolutionPipeline::pushAnagram(ExpanderState &state)
+{
+    state.ordered.assign(state.anagram.begin(), state.anagram.end());
+    std::ranges::sort(state.ordered);
+    state.anagrams.append(state.ordered, armaMagna.taggedOutput ? std::string_view(state.alternative->includedText) : std::string_view());
+
+    if(armaMagna.checkpoint == nullptr && state.anagrams.bytes() >= ANAGRAM_BATCH_BYTES) flushAnagrams(state);
+}
+
+//Publishes the local batch to the I/O ring
+void SolutionPipeline::flushAnagrams(ExpanderState &state)
+{
+    if(state.anagrams.empty()) return;
+
+    armaMagna.anagramRing.push(std::make_unique<AnagramBatch>(std::move(state.anagrams)));
+    state.anagrams = AnagramBatch();
+}
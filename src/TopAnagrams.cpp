@@ -0,0 +1,43 @@
+#include <algorithm>  //For std::push_heap, std::pop_heap, std::sort
+#include <limits>    //For std::numeric_limits
+#include <string>    //For std::string
+#include <vector>    //For std::vector
+#include <mutex>     //For std::mutex, std::lock_guard
+
+#include "TopAnagrams.h"
+
+TopAnagrams::TopAnagrams(size_t capacity)
+    : capacity(capacity), threshold(-std::numeric_limits<double>::infinity())
+{
+    heap.reserve(capacity + 1);
+}
+
+bool TopAnagrams::offer(double score, std::string &&text)
+{
+    if(score < getThreshold()) return false; //Most offers stop here, without the lock
+
+    std::lock_guard lock(heapMutex);
+    ScoredAnagram candidate{score, std::move(text)};
+    if(heap.size() == capacity && !(candidate < heap.front())) return false;
+
+    heap.push_back(std::move(candidate));
+    std::push_heap(heap.begin(), heap.end());
+    if(heap.size() > capacity)
+    {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.pop_back();
+    }
+    if(heap.size() == capacity) threshold.store(heap.front().score, std::memory_order_relaxed);
+    return true;
+}
+
+std::vector<ScoredAnagram> TopAnagrams::getSorted() const
+{
+    std::vector<ScoredAnagram> sorted;
+    {
+        std::lock_guard lock(heapMutex);
+        sorted = heap;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    return sorted;
+}
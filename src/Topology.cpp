@@ -0,0 +1,84 @@
+#include <vector> //For std::vector
+
+#ifdef __linux__
+#include <pthread.h> //For pthread_setaffinity_np
+#include <sched.h>   //For sched_getaffinity, sched_getcpu, cpu_set_t
+#endif
+#ifdef ARMAMAGNA_NUMA
+#include <numa.h>    //For numa_available, numa_max_node, numa_node_of_cpu, numa_run_on_node, numa_set_localalloc
+#endif
+
+#include "Topology.h"
+
+std::vector<int> Topology::allowedCpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for(int cpu=0; cpu<CPU_SETSIZE; cpu++)
+        {
+            if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+#endif
+    return cpus;
+}
+
+bool Topology::pinCurrentThread(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+int Topology::nodesNumber()
+{
+#ifdef ARMAMAGNA_NUMA
+    if(numa_available() < 0) return 1;
+    return numa_max_node() + 1;
+#else
+    return 1;
+#endif
+}
+
+int Topology::nodeOfCpu(int cpu)
+{
+#ifdef ARMAMAGNA_NUMA
+    if(numa_available() < 0 || cpu < 0) return 0;
+    const int node = numa_node_of_cpu(cpu);
+    return (node >= 0) ? node : 0;
+#else
+    (void)cpu;
+    return 0;
+#endif
+}
+
+int Topology::currentNode()
+{
+#ifdef ARMAMAGNA_NUMA
+    return nodeOfCpu(sched_getcpu());
+#else
+    return 0;
+#endif
+}
+
+bool Topology::runOnNode(int node)
+{
+#ifdef ARMAMAGNA_NUMA
+    if(numa_available() < 0 || numa_run_on_node(node) != 0) return false;
+    numa_set_localalloc(); //First touch: what the thread allocates from now on lives on the node
+    return true;
+#else
+    (void)node;
+    return false;
+#endif
+}
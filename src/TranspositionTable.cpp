@@ -0,0 +1,49 @@
+#include <cstdint>   //For uint32_t
+#include <cstddef>  //For size_t
+#include <mutex>   //For std::mutex, std::lock_guard
+
+#include "TranspositionTable.h"
+
+bool TranspositionTable::probe(const SubproblemKey &key, Completions &completions)
+{
+    Shard &shard = shardOf(key);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.records.find(key);
+    if(it == shard.records.end()) return false;
+    completions = it->second;
+    return true;
+}
+
+void TranspositionTable::store(const SubproblemKey &key, const Completions &completions)
+{
+    Shard &shard = shardOf(key);
+    std::lock_guard lock(shard.mutex);
+
+    auto it = shard.records.try_emplace(key).first;
+    shard.completionsMemory -= it->second.capacity() * sizeof(uint32_t);
+    it->second = completions;
+    shard.completionsMemory += it->second.capacity() * sizeof(uint32_t);
+
+    //Over its share, the shard starts over with no memory at all, the record just stored included
+    if(shard.memory() > TRANSPOSITION_TABLE_MEMORY_CAP / TRANSPOSITION_TABLE_SHARDS)
+    {
+        shard.records = Shard::Records();
+        shard.completionsMemory = 0;
+    }
+}
+
+void TranspositionTable::clear()
+{
+    for(Shard &shard : shards)
+    {
+        shard.records = Shard::Records(); //Releases the memory as well
+        shard.completionsMemory = 0;
+    }
+}
+
+TranspositionTable::Shard& TranspositionTable::shardOf(const SubproblemKey &key)
+{
+    //The low bits pick the bucket inside the shard's map, the high ones pick the shard
+    return shards[(SubproblemKeyHash{}(key) >> 58) % TRANSPOSITION_TABLE_SHARDS];
+}
@@ -0,0 +1,477 @@
+#include <string_view>  //For std::string_view
+#include <algorithm>    //For std::min, std::ranges::sort, std::ranges::unique, std::ranges::contains
+#include <expected>     //For std::expected, std::unexpected
+#include <cstdint>      //For int32_t
+#include <bitset>       //For std::bitset
+#include <memory>       //For std::unique_ptr, std::make_unique
+#include <string>       //For std::string
+#include <vector>       //For std::vector
+#include <map>          //For std::map
+
+#include "WordFilter.h"
+
+namespace
+{
+    const int MAX_REPEAT = 255; //Largest bound of a {m,n} repetition
+
+    using ByteSet = std::bitset<256>;
+
+    //Syntax tree of a regular expression
+    struct Node
+    {
+        enum class Type {Empty, Bytes, Concat, Alternation, Repeat} type = Type::Empty;
+        ByteSet bytes;                                 //Bytes
+        std::vector<std::unique_ptr<Node>> children;   //Concat, Alternation, Repeat (one child)
+        int min = 0, max = -1;                         //Repeat, -1 for no upper bound
+    };
+
+    //Any byte, any number of times
+    std::unique_ptr<Node> anyBytes()
+    {
+        auto bytes = std::make_unique<Node>();
+        bytes->type = Node::Type::Bytes;
+        bytes->bytes.set();
+
+        auto node = std::make_unique<Node>();
+        node->type = Node::Type::Repeat;
+        node->children.push_back(std::move(bytes));
+        return node;
+    }
+
+    //Recursive descent parser: pattern := branch ('|' branch)*, branch := '^'? concat '$'?,
+    //alternation := concat ('|' concat)*, concat := repeat*, repeat := atom quantifier*
+    class Parser
+    {
+    public:
+        explicit Parser(std::string_view pattern) : pattern(pattern) {}
+
+        //Whole word matcher: every top level branch is searched anywhere in the word, unless it's anchored
+        auto parse() -> std::expected<std::unique_ptr<Node>, std::string>
+        {
+            std::vector<std::unique_ptr<Node>> branches;
+            std::vector<bool> startAnchors, endAnchors;
+            while(true)
+            {
+                const bool startAnchored = !atEnd() && pattern[position] == '^';
+                if(startAnchored) position++;
+                auto branch = parseConcat();
+                if(!branch) return branch;
+                const bool endAnchored = atBranchEnd();
+                if(endAnchored) position++;
+
+                branches.push_back(std::move(branch.value()));
+                startAnchors.push_back(startAnchored);
+                endAnchors.push_back(endAnchored);
+                if(atEnd()) break;
+                if(pattern[position] != '|') return std::unexpected(error("unbalanced )"));
+                position++;
+            }
+
+            //Without any $, the word matches as soon as a match ends, and no branch needs its trailing .*
+            endAnchoredMatch = std::ranges::contains(endAnchors, true);
+            auto node = std::make_unique<Node>();
+            node->type = Node::Type::Alternation;
+            for(size_t i=0; i<branches.size(); i++)
+            {
+                auto branch = std::make_unique<Node>();
+                branch->type = Node::Type::Concat;
+                if(!startAnchors[i]) branch->children.push_back(anyBytes());
+                branch->children.push_back(std::move(branches[i]));
+                if(endAnchoredMatch && !endAnchors[i]) branch->children.push_back(anyBytes());
+                node->children.push_back(std::move(branch));
+            }
+            return node;
+        }
+
+        //True if the word must match up to its end, after parse()
+        bool endAnchored() const {return endAnchoredMatch;}
+
+    private:
+        std::string_view pattern;
+        size_t position = 0;
+        int depth = 0;                  //Open groups
+        bool endAnchoredMatch = false;
+
+        bool atEnd() const {return position == pattern.size();}
+
+        //A '$' anchors only the end of a top level branch
+        bool atBranchEnd() const
+        {
+            return depth == 0 && !atEnd() && pattern[position] == '$' &&
+                   (position + 1 == pattern.size() || pattern[position + 1] == '|');
+        }
+        std::string error(const std::string &what) const {return "Bad word filter '" + std::string(pattern) + "': " + what;}
+
+        auto parseAlternation() -> std::expected<std::unique_ptr<Node>, std::string>
+        {
+            auto first = parseConcat();
+            if(!first || atEnd() || pattern[position] != '|') return first;
+
+            auto node = std::make_unique<Node>();
+            node->type = Node::Type::Alternation;
+            node->children.push_back(std::move(first.value()));
+            while(!atEnd() && pattern[position] == '|')
+            {
+                position++;
+                auto next = parseConcat();
+                if(!next) return next;
+                node->children.push_back(std::move(next.value()));
+            }
+            return node;
+        }
+
+        auto parseConcat() -> std::expected<std::unique_ptr<Node>, std::string>
+        {
+            auto node = std::make_unique<Node>();
+            node->type = Node::Type::Concat;
+            while(!atEnd() && pattern[position] != '|' && pattern[position] != ')' && !atBranchEnd())
+            {
+                auto next = parseRepeat();
+                if(!next) return next;
+                node->children.push_back(std::move(next.value()));
+            }
+            return node;
+        }
+
+        auto parseRepeat() -> std::expected<std::unique_ptr<Node>, std::string>
+        {
+            auto atom = parseAtom();
+            if(!atom) return atom;
+
+            std::unique_ptr<Node> node = std::move(atom.value());
+            while(!atEnd())
+            {
+                int min = 0, max = -1;
+                const char c = pattern[position];
+                if(c == '*')      {min = 0; max = -1; position++;}
+                else if(c == '+') {min = 1; max = -1; position++;}
+                else if(c == '?') {min = 0; max = 1; position++;}
+                else if(c == '{')
+                {
+                    position++;
+                    if(!readNumber(min)) return std::unexpected(error("bad {m,n}"));
+                    max = min;
+                    if(!atEnd() && pattern[position] == ',')
+                    {
+                        position++;
+                        max = -1;
+                        if(!atEnd() && pattern[position] != '}' && !readNumber(max)) return std::unexpected(error("bad {m,n}"));
+                    }
+                    if(atEnd() || pattern[position] != '}' || (max >= 0 && max < min)) return std::unexpected(error("bad {m,n}"));
+                    position++;
+                }
+                else break;
+
+                auto repeat = std::make_unique<Node>();
+                repeat->type = Node::Type::Repeat;
+                repeat->min = min;
+                repeat->max = max;
+                repeat->children.push_back(std::move(node));
+                node = std::move(repeat);
+            }
+            return node;
+        }
+
+        auto parseAtom() -> std::expected<std::unique_ptr<Node>, std::string>
+        {
+            const char c = pattern[position++];
+            if(c == '(')
+            {
+                depth++;
+                auto node = parseAlternation();
+                depth--;
+                if(!node) return node;
+                if(atEnd() || pattern[position] != ')') return std::unexpected(error("missing )"));
+                position++;
+                return node;
+            }
+            if(c == '*' || c == '+' || c == '?' || c == '{') return std::unexpected(error("nothing to repeat"));
+            if(c == '^' || c == '$') return std::unexpected(error("^ and $ only anchor a top level branch, \\ escapes them"));
+
+            auto node = std::make_unique<Node>();
+            node->type = Node::Type::Bytes;
+            if(c == '.') node->bytes.set();
+            else if(c == '[')
+            {
+                auto bytes = parseClass();
+                if(!bytes) return std::unexpected(bytes.error());
+                node->bytes = bytes.value();
+            }
+            else if(c == '\\')
+            {
+                if(atEnd()) return std::unexpected(error("trailing \\"));
+                node->bytes.set(static_cast<unsigned char>(pattern[position++]));
+            }
+            else node->bytes.set(static_cast<unsigned char>(c));
+            return node;
+        }
+
+        //Called after the '['
+        auto parseClass() -> std::expected<ByteSet, std::string>
+        {
+            ByteSet bytes;
+            const bool complement = !atEnd() && pattern[position] == '^';
+            if(complement) position++;
+
+            bool first = true; //A ']' right after the '[' is a literal
+            while(!atEnd() && (pattern[position] != ']' || first))
+            {
+                first = false;
+                unsigned char low = static_cast<unsigned char>(pattern[position++]);
+                if(low == '\\' && !atEnd()) low = static_cast<unsigned char>(pattern[position++]);
+
+                unsigned char high = low;
+                if(position + 1 < pattern.size() && pattern[position] == '-' && pattern[position + 1] != ']')
+                {
+                    high = static_cast<unsigned char>(pattern[position + 1]);
+                    position += 2;
+                    if(high < low) return std::unexpected(error("bad range"));
+                }
+                for(int b=low; b<=high; b++) bytes.set(static_cast<size_t>(b));
+            }
+            if(atEnd()) return std::unexpected(error("missing ]"));
+            position++;
+
+            if(complement) bytes.flip();
+            return bytes;
+        }
+
+        bool readNumber(int &number)
+        {
+            const size_t begin = position;
+            number = 0;
+            while(!atEnd() && pattern[position] >= '0' && pattern[position] <= '9' && number <= MAX_REPEAT)
+            {
+                number = number * 10 + (pattern[position++] - '0');
+            }
+            return position > begin && number <= MAX_REPEAT;
+        }
+    };
+
+    //States of the Thompson NFA of a node, counted the way NfaBuilder adds them. Past 'cap' the count stops at cap + 1,
+    //so that nested repeats can't overflow it
+    size_t countStates(const Node &node, size_t cap)
+    {
+        size_t children = 0;
+        for(const auto &child : node.children) children = std::min(children + countStates(*child, cap), cap + 1);
+
+        size_t count = 0;
+        switch(node.type)
+        {
+            case Node::Type::Empty:       count = 1; break;
+            case Node::Type::Bytes:       count = 2; break;
+            case Node::Type::Concat:      count = 1 + children; break;
+            case Node::Type::Alternation: count = 2 + children; break;
+            case Node::Type::Repeat:
+                count = 1 + static_cast<size_t>(node.min) * children;
+                count += (node.max < 0) ? children + 1 : 1 + static_cast<size_t>(node.max - node.min) * children;
+                break;
+        }
+        return std::min(count, cap + 1);
+    }
+
+    //Thompson NFA: a state either reads a byte of its set and moves to 'next', or moves for free to its epsilons
+    struct NfaState
+    {
+        ByteSet bytes;
+        int next = -1;
+        std::vector<int> epsilons;
+    };
+
+    class NfaBuilder
+    {
+    public:
+        std::vector<NfaState> states;
+
+        //Builds the fragment of a node, returns its start and end states
+        std::pair<int, int> build(const Node &node)
+        {
+            const int start = addState();
+            int end = start;
+            switch(node.type)
+            {
+                case Node::Type::Empty:
+                    break;
+
+                case Node::Type::Bytes:
+                    end = addState();
+                    states[start].bytes = node.bytes;
+                    states[start].next = end;
+                    break;
+
+                case Node::Type::Concat:
+                    for(const auto &child : node.children)
+                    {
+                        auto [childStart, childEnd] = build(*child);
+                        states[end].epsilons.push_back(childStart);
+                        end = childEnd;
+                    }
+                    break;
+
+                case Node::Type::Alternation:
+                    end = addState();
+                    for(const auto &child : node.children)
+                    {
+                        auto [childStart, childEnd] = build(*child);
+                        states[start].epsilons.push_back(childStart);
+                        states[childEnd].epsilons.push_back(end);
+                    }
+                    break;
+
+                case Node::Type::Repeat:
+                    //Mandatory copies first, then either a loop or the optional copies
+                    for(int i=0; i<node.min; i++)
+                    {
+                        auto [childStart, childEnd] = build(*node.children[0]);
+                        states[end].epsilons.push_back(childStart);
+                        end = childEnd;
+                    }
+                    if(node.max < 0)
+                    {
+                        auto [childStart, childEnd] = build(*node.children[0]);
+                        const int loopEnd = addState();
+                        states[end].epsilons.push_back(childStart);
+                        states[end].epsilons.push_back(loopEnd);
+                        states[childEnd].epsilons.push_back(childStart);
+                        states[childEnd].epsilons.push_back(loopEnd);
+                        end = loopEnd;
+                    }
+                    else
+                    {
+                        const int optionalEnd = addState();
+                        for(int i=node.min; i<node.max; i++)
+                        {
+                            auto [childStart, childEnd] = build(*node.children[0]);
+                            states[end].epsilons.push_back(childStart);
+                            states[end].epsilons.push_back(optionalEnd);
+                            end = childEnd;
+                        }
+                        states[end].epsilons.push_back(optionalEnd);
+                        end = optionalEnd;
+                    }
+                    break;
+            }
+            return {start, end};
+        }
+
+        //States reachable from 'set' through epsilons, sorted
+        std::vector<int> closure(std::vector<int> set) const
+        {
+            std::vector<bool> seen(states.size(), false);
+            for(const int s : set) seen[s] = true;
+            for(size_t i=0; i<set.size(); i++)
+            {
+                for(const int e : states[set[i]].epsilons)
+                {
+                    if(!seen[e]) {seen[e] = true; set.push_back(e);}
+                }
+            }
+            std::ranges::sort(set);
+            return set;
+        }
+
+    private:
+        int addState()
+        {
+            states.emplace_back();
+            return static_cast<int>(states.size() - 1);
+        }
+    };
+
+    //Turns a glob into the equivalent regular expression, anchored at both ends
+    std::string globToRegex(std::string_view glob)
+    {
+        std::string regex = "^";
+        for(size_t i=0; i<glob.size(); i++)
+        {
+            const char c = glob[i];
+            if(c == '*')      regex += ".*";
+            else if(c == '?') regex += '.';
+            else if(c == '[')
+            {
+                const size_t close = glob.find(']', i + 2);
+                if(close == std::string_view::npos) {regex += "\\["; continue;}
+
+                std::string_view set = glob.substr(i + 1, close - i - 1);
+                regex += '[';
+                if(set.front() == '!') {regex += '^'; set.remove_prefix(1);}
+                regex += set;
+                regex += ']';
+                i = close;
+            }
+            else
+            {
+                if(std::string_view("\\.+()|{}^$").contains(c)) regex += '\\';
+                regex += c;
+            }
+        }
+        return regex + "$";
+    }
+}
+
+//Subset construction over the Thompson NFA of the whole word matcher
+auto WordFilter::compile(const std::string &pattern) -> std::expected<WordFilter, std::string>
+{
+    WordFilter filter;
+    std::string_view source = pattern;
+    if(source.starts_with('!')) {filter.negated = true; source.remove_prefix(1);}
+
+    std::string regex(source);
+    if(source.starts_with("glob:")) regex = globToRegex(source.substr(5));
+
+    Parser parser(regex);
+    auto tree = parser.parse();
+    if(!tree) {return std::unexpected(tree.error());}
+    filter.anchoredEnd = parser.endAnchored();
+    if(countStates(*tree.value(), MAX_FILTER_NFA_STATES) > MAX_FILTER_NFA_STATES) {return std::unexpected("Word filter '" + pattern + "' is too complex");}
+
+    NfaBuilder nfa;
+    auto [start, end] = nfa.build(*tree.value());
+
+    std::map<std::vector<int>, int32_t> ids;
+    std::vector<std::vector<int>> sets;
+    auto idOf = [&](std::vector<int> &&set) -> int32_t
+    {
+        auto [it, inserted] = ids.try_emplace(set, static_cast<int32_t>(sets.size()));
+        if(inserted) sets.push_back(std::move(set));
+        return it->second;
+    };
+    idOf(nfa.closure({start}));
+
+    for(size_t d=0; d<sets.size(); d++)
+    {
+        if(sets.size() > MAX_FILTER_STATES) {return std::unexpected("Word filter '" + pattern + "' is too complex");}
+
+        std::array<int32_t, 256> row;
+        for(size_t b=0; b<256; b++)
+        {
+            std::vector<int> moved;
+            for(const int s : sets[d])
+            {
+                if(nfa.states[s].next >= 0 && nfa.states[s].bytes.test(b)) moved.push_back(nfa.states[s].next);
+            }
+            std::ranges::sort(moved);
+            const auto [first, last] = std::ranges::unique(moved);
+            moved.erase(first, last);
+            row[b] = moved.empty() ? -1 : idOf(nfa.closure(std::move(moved)));
+        }
+        filter.transitions.push_back(row);
+        filter.accepting.push_back(std::ranges::binary_search(sets[d], end));
+    }
+
+    return filter;
+}
+
+bool WordFilter::accepts(std::string_view word) const
+{
+    int32_t state = 0;
+    bool matched = accepting[0] && !anchoredEnd;
+    for(size_t i=0; i<word.size() && !matched && state >= 0; i++)
+    {
+        state = transitions[static_cast<size_t>(state)][static_cast<unsigned char>(word[i])];
+        if(state >= 0 && !anchoredEnd) matched = accepting[static_cast<size_t>(state)];
+    }
+    if(anchoredEnd) matched = state >= 0 && accepting[static_cast<size_t>(state)];
+
+    return matched != negated;
+}
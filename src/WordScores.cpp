@@ -0,0 +1,64 @@
+#include <algorithm>      //For std::max, std::ranges::max
+#include <expected>      //For std::expected, std::unexpected
+#include <charconv>     //For std::from_chars
+#include <fstream>     //For std::ifstream
+#include <limits>     //For std::numeric_limits
+#include <string>    //For std::string, std::to_string
+#include <vector>   //For std::vector
+
+#include "Dictionarium.h"
+#include "WordScores.h"
+
+auto WordScores::readScores(const std::string &fileName) -> std::expected<size_t, std::string>
+{
+    std::ifstream file(fileName, std::ios::in);
+    if(!file) {return std::unexpected("Cannot open file " + fileName);}
+
+    std::string line;
+    size_t lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        const size_t end = line.find_last_not_of(" \t\r");
+        if(end == std::string::npos) continue; //Blank line
+
+        //The score is the last field, the word is everything before it
+        const size_t scoreBegin = line.find_last_of(" \t", end) + 1;
+        const size_t wordEnd = line.find_last_not_of(" \t", scoreBegin - 1);
+        if(scoreBegin == 0 || wordEnd == std::string::npos) {return std::unexpected("Missing score at line " + std::to_string(lineNumber) + " of " + fileName);}
+
+        double score = 0.0;
+        auto [scoreEnd, error] = std::from_chars(line.data() + scoreBegin, line.data() + end + 1, score);
+        if(error != std::errc() || scoreEnd != line.data() + end + 1) {return std::unexpected("Bad score at line " + std::to_string(lineNumber) + " of " + fileName);}
+
+        scores.insert_or_assign(line.substr(0, wordEnd + 1), score);
+    }
+
+    return scores.size();
+}
+
+double WordScores::getScore(const std::string &word) const
+{
+    auto it = scores.find(word);
+    return (it != scores.end()) ? it->second : 0.0;
+}
+
+void WordScores::indexDictionary(const Dictionarium &dictionary)
+{
+    sectionBest.fill(0.0);
+    for(auto &section : wordScores) section.clear();
+    for(const int length : dictionary.getAvailableLengths())
+    {
+        const std::vector<SectionEntry> &entries = dictionary.getSection(length).values();
+        wordScores[length].resize(entries.size());
+        entryBest[length].resize(entries.size());
+        sectionBest[length] = -std::numeric_limits<double>::infinity();
+
+        for(size_t i=0; i<entries.size(); i++)
+        {
+            for(const std::string &word : entries[i].second) wordScores[length][i].push_back(getScore(word));
+            entryBest[length][i] = std::ranges::max(wordScores[length][i]);
+            sectionBest[length] = std::max(sectionBest[length], entryBest[length][i]);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include <functional> //For std::function
+#include <cassert>   //For assert
+#include <memory>   //For std::make_unique
+#include <mutex>   //For std::mutex, std::lock_guard, std::unique_lock
+
+#include "WorkStealingPool.h"
+
+namespace
+{
+    thread_local const WorkStealingPool* currentPool = nullptr; //Pool of the calling thread, if it's a worker
+    thread_local size_t currentWorker = 0;                      //Its index in the pool
+}
+
+WorkStealingPool::WorkStealingPool(int workersNumber)
+{
+    assert(workersNumber > 0);
+    for(int i=0; i<workersNumber; i++) workers.push_back(std::make_unique<Worker>());
+    for(size_t i=0; i<workers.size(); i++) threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    join();
+}
+
+void WorkStealingPool::post(std::function<void()> task)
+{
+    enqueue(nullptr, std::move(task));
+}
+
+void WorkStealingPool::spawn(std::function<void()> task)
+{
+    enqueue((currentPool == this) ? workers[currentWorker].get() : nullptr, std::move(task));
+}
+
+//The counter of queued tasks is only raised under the pool mutex, after the task is visible, so that a worker that
+//checked it before going to sleep is always woken up
+void WorkStealingPool::enqueue(Worker* worker, std::function<void()> &&task)
+{
+    pendingTasks++;
+    if(worker != nullptr)
+    {
+        std::lock_guard lock(worker->mutex);
+        worker->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        if(worker == nullptr) sharedTasks.push_back(std::move(task));
+        queuedTasks++;
+    }
+    workCV.notify_one();
+}
+
+void WorkStealingPool::join()
+{
+    {
+        std::unique_lock lock(mutex);
+        doneCV.wait(lock, [this] {return pendingTasks == 0;});
+        stopping = true;
+    }
+    workCV.notify_all();
+
+    for(std::jthread &thread : threads)
+    {
+        if(thread.joinable()) thread.join();
+    }
+}
+
+void WorkStealingPool::workerLoop(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+
+    std::function<void()> task;
+    while(true)
+    {
+        if(take(index, task))
+        {
+            queuedTasks--;
+            task();
+            task = nullptr;
+
+            if(--pendingTasks == 0)
+            {
+                std::lock_guard lock(mutex);
+                doneCV.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock lock(mutex);
+        if(stopping) break;
+        idleWorkers++;
+        workCV.wait(lock, [this] {return queuedTasks > 0 || stopping;});
+        idleWorkers--;
+    }
+
+    currentPool = nullptr;
+}
+
+//Own deque from the back, shared queue from the front, then the other deques from the front
+bool WorkStealingPool::take(size_t index, std::function<void()> &task)
+{
+    {
+        Worker &own = *workers[index];
+        std::lock_guard lock(own.mutex);
+        if(!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        if(!sharedTasks.empty())
+        {
+            task = std::move(sharedTasks.front());
+            sharedTasks.pop_front();
+            return true;
+        }
+    }
+
+    for(size_t i=1; i<workers.size(); i++)
+    {
+        Worker &victim = *workers[(index + i) % workers.size()];
+        std::lock_guard lock(victim.mutex);
+        if(!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,46 +1,193 @@
 #include <iostream>    //For std::cout
+#include <fstream>     //For std::ifstream, std::ofstream
 #include <string>      //For std::string
+#include <vector>      //For std::vector
+#include <charconv>    //For std::from_chars
+#include <algorithm>   //For std::sort
+#include <csignal>     //For std::signal, SIGINT
+#include <filesystem>  //For std::filesystem::equivalent, std::error_code
 
 #include "ArmaMagna.h"
+#include "TopAnagrams.h"
 
 #include <CLI11.hpp>
 
 void printUsage();
+void onInterrupt(int signalNumber);
+int mergeShards(int argc, char **argv);
+bool parseShard(const std::string &shard, int &index, int &number);
 bool readArguments(int argc, char **argv, std::string &source, std::string &dictionary, std::string &includedText,
                    int &minCardinality, int &maxCardinality);
 
 int main(int argc, char **argv)
 {
+    //Subcommands
+    if(argc > 1 && std::string(argv[1]) == "merge") return mergeShards(argc - 1, argv + 1);
+
     //Command line argument variables, set to illegal value
     std::string target       = "";
     std::string dictionary   = "";
-    std::string includedText = "";
+    std::vector<std::string> includedTexts;
     std::string outputFile   = "anagrams.txt";
     int minCardinality  = -1;
     int maxCardinality  = -1;
+    int minLength       = 1;
+    int maxLength       = MAX_WORD_LENGTH;
     unsigned int numThreads = std::thread::hardware_concurrency();
+    std::string schedule     = "throughput";
+    std::string engine       = "recursive";
+    unsigned int numExpanders = 1;
+    unsigned long long limit = 0;
+    double timeout = 0.0;
+    double checkpointPeriod = 0.0;
+    bool resume = false;
+    std::string shard        = "1/1";
+    size_t top = 0;
+    std::string scoresFile   = "";
+    std::string excludeFile  = "";
+    std::vector<std::string> anyOf;
+    std::vector<std::string> wordFilters;
+    bool pin = false;
 
     CLI::App app("ArmaMagna");
 
     app.add_option("text", target, "Text to anagram")->required();
     app.add_option("-d,--dict", dictionary, "Dictionary file path")->required();
-    app.add_option("-i,--incl", includedText, "Included text");
+    app.add_option("-i,--incl", includedTexts, "Included text; repeated, the alternatives are searched in one run and tag their anagrams");
     app.add_option("--mincard", minCardinality, "Minimum cardinality")->required()->check(CLI::PositiveNumber);
     app.add_option("--maxcard", maxCardinality, "Maximum cardinality")->required()->check(CLI::PositiveNumber);
+    app.add_option("--minlen", minLength, "Minimum length of the words")->check(CLI::PositiveNumber);
+    app.add_option("--maxlen", maxLength, "Maximum length of the words")->check(CLI::PositiveNumber);
+    app.add_option("--exclude-file", excludeFile, "Words never used, one per line, as written in the dictionary")->check(CLI::ExistingFile);
+    app.add_option("--any-of", anyOf, "Every anagram includes at least one of these words, as word1,word2,...")->delimiter(',');
+    app.add_option("--word-filter", wordFilters, "Keeps the dictionary words matching a regex, or a glob with 'glob:', '!' to invert; repeatable");
     app.add_option("-o,--out", outputFile, "Output file");
     app.add_option("-t,--thr", numThreads, "Number of threads")->check(CLI::PositiveNumber);
-    app.footer("Example:\n\tarmamagna \"bazzecole andanti\" -d it.txt --mincard=1 --maxcard=3\n\n" \
+    app.add_flag("--pin", pin, "Binds every search thread to a core, each NUMA node gets its own copy of the dictionary");
+    app.add_option("--expanders", numExpanders, "Number of threads expanding signature solutions into words")->check(CLI::PositiveNumber);
+    app.add_option("--limit", limit, "Stops the search after this many anagrams, 0 for no limit")->check(CLI::NonNegativeNumber);
+    app.add_option("--timeout", timeout, "Stops the search after this many seconds, 0 for no time budget")->check(CLI::NonNegativeNumber);
+    app.add_option("--checkpoint", checkpointPeriod, "Saves the progress to <out>.checkpoint every this many seconds")->check(CLI::NonNegativeNumber);
+    app.add_flag("--resume", resume, "Resumes the search saved in <out>.checkpoint");
+    app.add_option("--shard", shard, "Searches only shard K of N, as K/N; 'armamagna merge' combines the shard outputs");
+    app.add_option("--top", top, "Outputs only the K best anagrams, ranked by the sum of their word scores")->check(CLI::PositiveNumber);
+    app.add_option("--scores", scoresFile, "Word scores of --top, one 'word score' per line, missing words score 0")->check(CLI::ExistingFile);
+    app.add_option("--engine", engine, "Search engine: recursive, iterative or letter")->check(CLI::IsMember({"recursive", "iterative", "letter"}));
+    app.add_option("--schedule", schedule, "Schedule policy: throughput or first-results")->check(CLI::IsMember({"throughput", "first-results"}));
+    app.footer("Example:\n\tarmamagna \"bazzecole andanti\" -d it.txt --mincard=1 --maxcard=3\n" \
+                "\tarmamagna merge -o anagrams.txt shard1.txt shard2.txt\n\n" \
                 "Author: Gabriele Cassetta, @merhametsize");
 
     CLI11_PARSE(app, argc, argv);
 
     //Starts anagramming
     ArmaMagna am;
-    auto ret = am.setOptions(target, dictionary, outputFile, includedText, minCardinality, maxCardinality, numThreads);
+    auto ret = am.setOptions(target, dictionary, outputFile, includedTexts, minCardinality, maxCardinality, numThreads);
+    if(!ret) {std::cout << ret.error() << std::endl; return -1;}
+    ret = am.setLengthBounds(minLength, maxLength);
+    if(!ret) {std::cout << ret.error() << std::endl; return -1;}
+    am.setSchedulePolicy((schedule == "first-results") ? SchedulePolicy::FirstResults : SchedulePolicy::Throughput);
+    if(engine == "letter")         am.setSearchEngine(SearchEngine::Letter);
+    else if(engine == "iterative") am.setSearchEngine(SearchEngine::Iterative);
+    else                           am.setSearchEngine(SearchEngine::Recursive);
+    am.setExpandersNumber(numExpanders);
+    am.setPinning(pin);
+    ret = am.setBudget(limit, timeout);
+    if(!ret) {std::cout << ret.error() << std::endl; return -1;}
+    ret = am.setCheckpointing(checkpointPeriod, resume);
+    if(!ret) {std::cout << ret.error() << std::endl; return -1;}
+    int shardIndex = 0, shardsNumber = 0;
+    if(!parseShard(shard, shardIndex, shardsNumber)) {std::cout << "The shard must be K/N" << std::endl; return -1;}
+    ret = am.setShard(shardIndex, shardsNumber);
+    if(!ret) {std::cout << ret.error() << std::endl; return -1;}
+
+    if(top > 0 && scoresFile.empty()) {std::cout << "--top needs a --scores file" << std::endl; return -1;}
+    am.setRanking(top, scoresFile);
+    am.setExclusions(excludeFile, anyOf);
+    ret = am.setWordFilters(wordFilters);
     if(!ret) {std::cout << ret.error() << std::endl; return -1;}
 
+    //Ctrl+C stops the search cleanly and keeps the anagrams found so far, a second one kills the process
+    std::signal(SIGINT, onInterrupt);
+
     auto anagramsFound = am.anagram();
     if(!anagramsFound) {std::cout << anagramsFound.error() << std::endl; return -1;}
 
     return 0;
-}
\ No newline at end of file
+}
+
+void onInterrupt(int)
+{
+    ArmaMagna::interrupt();
+    std::signal(SIGINT, SIG_DFL);
+}
+
+//armamagna merge: the shards are disjoint, so their outputs are concatenated. The top anagrams of ranked shards are
+//ranked again, and the best K of them kept
+int mergeShards(int argc, char **argv)
+{
+    std::vector<std::string> shardFiles;
+    std::string outputFile = "anagrams.txt";
+    size_t top = 0;
+
+    CLI::App app("ArmaMagna merge, combines the outputs of the shards of a search");
+    app.add_option("shards", shardFiles, "Output files of the shards")->required()->check(CLI::ExistingFile);
+    app.add_option("-o,--out", outputFile, "Output file");
+    app.add_option("--top", top, "Keeps the K best anagrams of shards searched with --top")->check(CLI::PositiveNumber);
+    CLI11_PARSE(app, argc, argv);
+
+    //Checked before the output is opened, which truncates it. Aliases of the same file (./s1.txt, links) count too
+    for(const std::string &shardFile : shardFiles)
+    {
+        std::error_code error; //A missing output file is no shard
+        if(std::filesystem::equivalent(shardFile, outputFile, error)) {std::cout << "The output file can't be one of the shards" << std::endl; return -1;}
+    }
+
+    std::ofstream output(outputFile, std::ios::out | std::ios::binary);
+    if(!output) {std::cout << "Cannot open output file" << std::endl; return -1;}
+
+    unsigned long long anagramsNumber = 0;
+    std::vector<ScoredAnagram> ranked; //Lines of ranked shards, with their score
+    for(const std::string &shardFile : shardFiles)
+    {
+        std::ifstream input(shardFile, std::ios::in | std::ios::binary);
+        if(!input) {std::cout << "Cannot open " << shardFile << std::endl; return -1;}
+
+        std::string line;
+        while(std::getline(input, line))
+        {
+            if(top == 0) {output << line << '\n'; anagramsNumber++; continue;}
+
+            const size_t tab = line.rfind('\t');
+            double score = 0.0;
+            if(tab == std::string::npos || std::from_chars(line.data() + tab + 1, line.data() + line.size(), score).ec != std::errc())
+            {
+                std::cout << shardFile << " is not the output of a ranked search" << std::endl;
+                return -1;
+            }
+            ranked.push_back({score, std::move(line)});
+        }
+    }
+
+    if(top > 0)
+    {
+        std::sort(ranked.begin(), ranked.end());
+        if(ranked.size() > top) ranked.resize(top);
+        for(const ScoredAnagram &anagram : ranked) output << anagram.text << '\n';
+        anagramsNumber = ranked.size();
+    }
+
+    std::cout << "[*] Merged " << shardFiles.size() << " shards, " << anagramsNumber << " anagrams in " << outputFile << std::endl;
+    return 0;
+}
+
+bool parseShard(const std::string &shard, int &index, int &number)
+{
+    const size_t slash = shard.find('/');
+    if(slash == std::string::npos) return false;
+
+    const char* end = shard.data() + shard.size();
+    auto [indexEnd, indexError] = std::from_chars(shard.data(), shard.data() + slash, index);
+    auto [numberEnd, numberError] = std::from_chars(shard.data() + slash + 1, end, number);
+    return indexError == std::errc() && numberError == std::errc() && indexEnd == shard.data() + slash && numberEnd == end;
+}
@@ -0,0 +1,19 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <print>    //For std::println
+#include <string>  //For std::string
+
+//Minimal test harness: every failed check is printed, and the test returns how many failed
+inline int failedChecks = 0;
+
+inline void check(bool condition, const std::string &what, int line)
+{
+    if(condition) return;
+    std::println(stderr, "FAILED line {}: {}", line, what);
+    failedChecks++;
+}
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+#endif
@@ -0,0 +1,72 @@
+#include <filesystem>  //For std::filesystem
+#include <algorithm>   //For std::ranges::sort, std::ranges::adjacent_find
+#include <fstream>     //For std::ifstream
+#include <string>      //For std::string
+#include <vector>      //For std::vector
+
+#include "ArmaMagna.h"
+#include "Check.h"
+
+const std::string TARGET = "the eyes they see";
+const std::string DICTIONARY = "data/eng.txt";
+const int MIN_CARDINALITY = 1, MAX_CARDINALITY = 6;
+const unsigned int THREADS = 6;
+
+//Runs the test search into 'output', stopped after 'limit' anagrams in all (0 for none), checkpointed if 'checkpointed'
+static auto run(const std::string &output, unsigned long long limit, bool checkpointed, bool resume,
+                SearchEngine engine = SearchEngine::Recursive) -> std::expected<unsigned long long, std::string>
+{
+    ArmaMagna am;
+    auto ret = am.setOptions(TARGET, DICTIONARY, output, {}, MIN_CARDINALITY, MAX_CARDINALITY, THREADS);
+    if(!ret) {return std::unexpected(ret.error());}
+    am.setSearchEngine(engine);
+    ret = am.setBudget(limit, 0.0);
+    if(!ret) {return std::unexpected(ret.error());}
+    if(checkpointed)
+    {
+        ret = am.setCheckpointing(0.001, resume);
+        if(!ret) {return std::unexpected(ret.error());}
+    }
+    return am.anagram();
+}
+
+//Lines of a file, sorted: the threads write the anagrams in any order
+static std::vector<std::string> sortedLines(const std::string &fileName)
+{
+    std::ifstream file(fileName);
+    std::vector<std::string> lines;
+    std::string line;
+    while(std::getline(file, line)) lines.push_back(line);
+    std::ranges::sort(lines);
+    return lines;
+}
+
+int main()
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string whole = (directory / "armamagna_checkpoint_whole.txt").string();
+    const std::string resumed = (directory / "armamagna_checkpoint_resumed.txt").string();
+
+    auto found = run(whole, 0, false, false);
+    CHECK(found.has_value());
+    const std::vector<std::string> expected = sortedLines(whole);
+    CHECK(expected.size() > 100000);
+    CHECK(std::ranges::adjacent_find(expected) == expected.end());
+
+    //Stopped twice in the middle of batches, then resumed to the end: the partial batches are truncated and redone,
+    //the batches already written are skipped
+    CHECK(run(resumed, 20000, true, false).has_value());
+    CHECK(run(resumed, 60000, true, true).has_value());
+    found = run(resumed, 0, true, true);
+    CHECK(found.has_value() && found.value() == expected.size());
+    CHECK(sortedLines(resumed) == expected);
+
+    //The checkpoint belongs to the options of its search, the engine included
+    CHECK(run(resumed, 20000, true, false).has_value());
+    CHECK(!run(resumed, 0, true, true, SearchEngine::Iterative).has_value());
+    CHECK(run(resumed, 0, true, true).has_value());
+    CHECK(sortedLines(resumed) == expected);
+
+    for(const std::string &file : {whole, resumed, resumed + ".checkpoint"}) std::filesystem::remove(file);
+    return failedChecks;
+}
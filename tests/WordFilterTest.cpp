@@ -0,0 +1,91 @@
+#include <string>    //For std::string
+#include <vector>   //For std::vector
+
+#include "WordFilter.h"
+#include "Check.h"
+
+//True if the pattern compiles and accepts the word
+static bool accepts(const std::string &pattern, const std::string &word)
+{
+    auto filter = WordFilter::compile(pattern);
+    return filter && filter->accepts(word);
+}
+
+static bool rejected(const std::string &pattern)
+{
+    return !WordFilter::compile(pattern).has_value();
+}
+
+int main()
+{
+    //Unanchored patterns are searched anywhere in the word
+    CHECK(accepts("ab", "xaby"));
+    CHECK(!accepts("ab", "ba"));
+    CHECK(accepts("", "word"));
+
+    //Anchors hold for the whole pattern, or for each top level branch
+    CHECK(accepts("^ab$", "ab"));
+    CHECK(!accepts("^ab$", "abc"));
+    CHECK(!accepts("^ab$", "cab"));
+    CHECK(accepts("^a|b$", "ax"));
+    CHECK(accepts("^a|b$", "xb"));
+    CHECK(!accepts("^a|b$", "xa"));
+    CHECK(!accepts("^a|b$", "bx"));
+    CHECK(accepts("x|^y$", "axb"));
+    CHECK(accepts("x|^y$", "y"));
+    CHECK(!accepts("x|^y$", "yy"));
+    CHECK(accepts("^(a|b)c$", "bc"));
+    CHECK(accepts("^$", ""));
+    CHECK(!accepts("^$", "a"));
+
+    //Anchors anywhere else are rejected, escaped they are literals
+    for(const std::string pattern : {"a^b", "a$b", "(^a)", "(a$)", "$a", "^^a"}) CHECK(rejected(pattern));
+    CHECK(accepts("a\\$", "a$"));
+    CHECK(!accepts("a\\$", "a"));
+    CHECK(accepts("[$^]", "x^"));
+
+    //Repeats
+    CHECK(accepts("^a{3}$", "aaa"));
+    CHECK(!accepts("^a{3}$", "aa"));
+    CHECK(!accepts("^a{3}$", "aaaa"));
+    CHECK(accepts("^a{2,}$", "aaaaa"));
+    CHECK(!accepts("^a{2,}$", "a"));
+    CHECK(accepts("^a{1,3}b$", "aab"));
+    CHECK(!accepts("^a{1,3}b$", "aaaab"));
+    CHECK(accepts("^ab*c+d?$", "acc"));
+    CHECK(!accepts("^ab*c+d?$", "abd"));
+    for(const std::string pattern : {"a{3,1}", "a{", "a{256}", "*a", "a**b{", "(a", "a)"}) CHECK(rejected(pattern));
+
+    //Classes
+    CHECK(accepts("^[a-c]+$", "abcab"));
+    CHECK(!accepts("^[a-c]+$", "abd"));
+    CHECK(accepts("^[^aeiou]+$", "rhythm"));
+    CHECK(!accepts("^[^aeiou]+$", "rhyme"));
+    CHECK(accepts("^[]a]$", "]"));
+    CHECK(accepts("^.$", "z"));
+    CHECK(rejected("[abc"));
+    CHECK(rejected("[z-a]"));
+
+    //Negation keeps the words that don't match
+    CHECK(accepts("!(aa|bb)", "abab"));
+    CHECK(!accepts("!(aa|bb)", "abba"));
+    CHECK(accepts("!^x", "ax"));
+
+    //Globs match the whole word
+    CHECK(accepts("glob:*ing", "sing"));
+    CHECK(!accepts("glob:*ing", "singer"));
+    CHECK(accepts("glob:?at", "cat"));
+    CHECK(!accepts("glob:?at", "at"));
+    CHECK(accepts("glob:[!c]at", "bat"));
+    CHECK(!accepts("glob:[!c]at", "cat"));
+    CHECK(accepts("glob:a.b$", "a.b$"));
+    CHECK(!accepts("glob:a.b", "axb"));
+    CHECK(accepts("!glob:*s", "word"));
+
+    //Automata too large are rejected, before they are built
+    CHECK(rejected("((a{255}){255}){255}"));
+    CHECK(rejected("(a|b|c|d|e|f|g|h)*a(a|b|c|d|e|f|g|h){12}$"));
+    CHECK(!rejected("^[a-z]{3,20}$"));
+
+    return failedChecks;
+}
@@ -0,0 +1,122 @@
+#include <functional>  //For std::function
+#include <algorithm>   //For std::ranges::sort, std::ranges::unique
+#include <chrono>      //For std::chrono
+#include <thread>      //For std::this_thread
+#include <atomic>      //For std::atomic
+#include <vector>      //For std::vector
+#include <mutex>       //For std::mutex, std::lock_guard
+
+#include "WorkStealingPool.h"
+#include "Check.h"
+
+using namespace std::chrono_literals;
+
+//Spawns two children down to depth 0, every task counts itself once it's done
+static void spawnTree(WorkStealingPool &pool, int depth, std::atomic<int> &done)
+{
+    if(depth > 0)
+    {
+        pool.spawn([&pool, depth, &done] {spawnTree(pool, depth - 1, done);});
+        pool.spawn([&pool, depth, &done] {spawnTree(pool, depth - 1, done);});
+    }
+    else std::this_thread::sleep_for(100us);
+    done++;
+}
+
+int main()
+{
+    //Posted tasks all run before join returns
+    {
+        std::atomic<int> done = 0;
+        WorkStealingPool pool(4);
+        for(int i=0; i<1000; i++) pool.post([&done] {done++;});
+        pool.join();
+        CHECK(done == 1000);
+    }
+
+    //Join waits for the subtasks spawned by running tasks, and theirs, even once the posted task is over
+    {
+        std::atomic<int> done = 0;
+        WorkStealingPool pool(4);
+        pool.post([&pool, &done] {spawnTree(pool, 10, done);});
+        pool.join();
+        CHECK(done == (1 << 11) - 1);
+    }
+
+    //With a single worker the order is fixed: the shared queue is first in first out, the worker's deque last in first out
+    {
+        std::vector<int> order;
+        WorkStealingPool pool(1);
+        for(int i=0; i<3; i++) pool.post([&order, i] {order.push_back(i);});
+        pool.post([&pool, &order]
+        {
+            for(int i=3; i<6; i++) pool.spawn([&order, i] {order.push_back(i);});
+        });
+        pool.join();
+        CHECK((order == std::vector<int>{0, 1, 2, 5, 4, 3}));
+    }
+
+    //The tasks spawned by a busy worker are stolen by the idle ones, which ask for work meanwhile
+    {
+        std::mutex mutex;
+        std::vector<std::thread::id> runners;
+        std::atomic<bool> askedForWork = false;
+        WorkStealingPool pool(4);
+        pool.post([&]
+        {
+            for(int i=0; i<64; i++)
+            {
+                pool.spawn([&]
+                {
+                    std::this_thread::sleep_for(1ms);
+                    std::lock_guard lock(mutex);
+                    runners.push_back(std::this_thread::get_id());
+                });
+            }
+
+            //Keeps its worker busy until the others are idle with nothing left to take
+            const auto deadline = std::chrono::steady_clock::now() + 5s;
+            while(!pool.wantsWork() && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(1ms);
+            askedForWork = pool.wantsWork();
+        });
+        pool.join();
+
+        CHECK(runners.size() == 64);
+        std::ranges::sort(runners);
+        const auto [first, last] = std::ranges::unique(runners);
+        runners.erase(first, last);
+        CHECK(runners.size() > 1);
+        CHECK(askedForWork);
+    }
+
+    //Spawning outside of a worker posts on the shared queue
+    {
+        std::atomic<int> done = 0;
+        WorkStealingPool pool(2);
+        pool.spawn([&done] {done++;});
+        pool.join();
+        CHECK(done == 1);
+    }
+
+    //A pool destroyed with work still queued runs all of it first, and a second join is harmless
+    {
+        std::atomic<int> done = 0;
+        std::atomic<bool> released = false;
+        {
+            WorkStealingPool pool(2);
+            for(int i=0; i<200; i++) pool.post([&done, &released] {released.wait(false); done++;});
+            CHECK(done == 0);
+            released = true;
+            released.notify_all();
+        }
+        CHECK(done == 200);
+
+        WorkStealingPool pool(2);
+        pool.post([&done] {done++;});
+        pool.join();
+        pool.join();
+        CHECK(done == 201);
+    }
+
+    return failedChecks;
+}